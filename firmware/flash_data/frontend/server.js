@@ -192,8 +192,13 @@ window.addEventListener('load', function () {
 
 function getTimeZonesAndTimeInfo() {
     const timeZoneDropdown = document.getElementById("selectTimeZone");
-    fetch("zones.json")
-        .then(response => response.json())
+    fetch("/api/v1/clock/zones")
+        .then(response => {
+            if (!response.ok) {
+                throw new Error('Network response was not ok');
+            }
+            return response.json();
+        })
         .then(data => {
             // data is an object { "Africa/Abidjan": "GMT0", ... }
             for (const [zone, offset] of Object.entries(data)) {
@@ -0,0 +1,29 @@
+/******************************************************************************
+ * File:    calibration_info.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Implements CalibrationInfo data class
+ ******************************************************************************/
+
+#include "calibration_info.h"
+
+CalibrationInfo::CalibrationInfo(int8_t agingOffset, int32_t driftPpb,
+                                 uint32_t syncInterval)
+    : mAgingOffset(agingOffset), mDriftPpb(driftPpb),
+      mSyncInterval(syncInterval) {}
+
+int8_t CalibrationInfo::getAgingOffset() const { return mAgingOffset; }
+
+void CalibrationInfo::setAgingOffset(const int8_t value) {
+    mAgingOffset = value;
+}
+
+int32_t CalibrationInfo::getDriftPpb() const { return mDriftPpb; }
+
+void CalibrationInfo::setDriftPpb(const int32_t value) { mDriftPpb = value; }
+
+uint32_t CalibrationInfo::getSyncInterval() const { return mSyncInterval; }
+
+void CalibrationInfo::setSyncInterval(const uint32_t value) {
+    mSyncInterval = value;
+}
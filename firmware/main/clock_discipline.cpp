@@ -0,0 +1,188 @@
+/******************************************************************************
+ * File:    clock_discipline.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Implements ClockDiscipline class
+ ******************************************************************************/
+
+#include "clock_discipline.h"
+
+#include <cstdlib>
+#include <mutex>
+#include <sys/time.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char* kTag = "clock_discipline";
+static constexpr int64_t kUsPerSecond = 1000000;
+static constexpr int64_t kUsPerMinute = 60 * kUsPerSecond;
+// Offsets above this are stepped, smaller ones are slewed
+static constexpr int64_t kStepThresholdUs = 50000;
+static constexpr int64_t kMaxSlewRemainingUs = 1000;
+
+ClockDiscipline::ClockDiscipline(Ds3231& rtc, RtcCalibrator& calibrator)
+    : mRtc(rtc), mCalibrator(calibrator), mLastEdgeUs(0), mRtcOffsetUs(0),
+      mIsLocked(false), mIsNtpSyncPending(false), mIsSamplePending(false),
+      mIsRtcWritePending(false), mIsReferencePending(false) {}
+
+void ClockDiscipline::initialize(gpio_num_t sqwPin) {
+    esp_err_t err = mRtc.enableSquareWave(sqwPin);
+    if (err != ESP_OK) {
+        ESP_LOGE(kTag, "Failed to enable RTC square wave: %s",
+                 esp_err_to_name(err));
+    }
+}
+
+bool ClockDiscipline::update() {
+    std::lock_guard<Mutex> lock(mMutex);
+    if (mIsNtpSyncPending) {
+        // NTP owns the clock until its offset is slewed out
+        mIsNtpSyncPending = !handleNtpSync();
+        return false;
+    }
+
+    int64_t edgeUs = mRtc.getLastEdgeUs();
+    if (edgeUs == mLastEdgeUs) {
+        return false;   // no new edge
+    }
+    int64_t offsetUs;
+    if (!measureOffset(edgeUs, !mIsLocked || mIsReferencePending,
+                       &offsetUs)) {
+        return false;
+    }
+    mLastEdgeUs = edgeUs;
+    if (mIsReferencePending) {
+        // The RTC was just set to the NTP time, what is left of its phase
+        // error is the new reference instead of a correction
+        mRtcOffsetUs = offsetUs;
+        mIsReferencePending = false;
+        mIsLocked = true;
+        return false;
+    }
+    offsetUs -= mRtcOffsetUs;
+
+    if (llabs(offsetUs) <= kStepThresholdUs) {
+        struct timeval delta = {.tv_sec = 0, .tv_usec = (suseconds_t) offsetUs};
+        adjtime(&delta, nullptr);
+        mIsLocked = true;
+        return false;
+    }
+    if (mIsLocked) {
+        // A large phase error of a locked clock is suspicious, resolve the
+        // whole seconds again before stepping
+        mIsLocked = false;
+        return false;
+    }
+
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    int64_t correctedUs = tv.tv_sec * kUsPerSecond + tv.tv_usec + offsetUs;
+    tv.tv_sec = correctedUs / kUsPerSecond;
+    tv.tv_usec = correctedUs % kUsPerSecond;
+    settimeofday(&tv, nullptr);
+    mIsLocked = true;
+    ESP_LOGI(kTag, "System clock stepped by %lld us to the RTC", offsetUs);
+    return true;
+}
+
+void ClockDiscipline::onNtpSync() {
+    std::lock_guard<Mutex> lock(mMutex);
+    mIsNtpSyncPending = true;
+    // The NTP offset was just stepped or handed to adjtime(), so the RTC
+    // offset against the synchronized time is known right away. The minute
+    // alarm of the low power mode is too old for that, the sample waits for
+    // the next alarm then.
+    int64_t offsetUs;
+    mIsSamplePending = !measureOffset(mRtc.getLastEdgeUs(), true, &offsetUs);
+    if (!mIsSamplePending) {
+        addSample(offsetUs - getRemainingSlewUs());
+    }
+}
+
+bool ClockDiscipline::measureOffset(int64_t edgeUs, bool resolveSeconds,
+                                    int64_t* offsetUs) {
+    int64_t nowUs = esp_timer_get_time();
+    if (edgeUs == 0 || nowUs - edgeUs >= kUsPerSecond) {
+        return false;   // the square wave is not running
+    }
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    int64_t systemAtEdgeUs =
+        tv.tv_sec * kUsPerSecond + tv.tv_usec - (nowUs - edgeUs);
+
+    // The RTC time at the edge is a whole second
+    if (!resolveSeconds) {
+        *offsetUs = -(systemAtEdgeUs % kUsPerSecond);
+        if (*offsetUs <= -kUsPerSecond / 2) {
+            *offsetUs += kUsPerSecond;
+        }
+        return true;
+    }
+
+    // The seconds register holds the second which started at the edge as
+    // long as no other edge came during the read
+    struct tm rtcTm;
+    if (!mRtc.getTime(&rtcTm) || mRtc.getLastEdgeUs() != edgeUs) {
+        return false;
+    }
+    *offsetUs = rtcTm.tm_sec * kUsPerSecond - systemAtEdgeUs % kUsPerMinute;
+    if (*offsetUs > kUsPerMinute / 2) {
+        *offsetUs -= kUsPerMinute;
+    } else if (*offsetUs <= -kUsPerMinute / 2) {
+        *offsetUs += kUsPerMinute;
+    }
+    return true;
+}
+
+bool ClockDiscipline::handleNtpSync() {
+    // NTP offsets are slewed, wait until the system time got there
+    int64_t remainingUs = getRemainingSlewUs();
+    if (llabs(remainingUs) > kMaxSlewRemainingUs) {
+        return false;
+    }
+
+    if (mIsSamplePending) {
+        // Without the square wave the drift cannot be measured, the RTC is
+        // just kept in sync
+        int64_t offsetUs;
+        if (measureOffset(mRtc.getLastEdgeUs(), true, &offsetUs)) {
+            addSample(offsetUs - remainingUs);
+        } else {
+            mIsRtcWritePending = true;
+        }
+        mIsSamplePending = false;
+    }
+    if (mIsRtcWritePending) {
+        mIsReferencePending = writeRtc();
+        mIsRtcWritePending = false;
+    }
+    return true;
+}
+
+void ClockDiscipline::addSample(int64_t offsetUs) {
+    // The system clock follows the RTC shifted by its offset against NTP
+    // until the next sync, unless the RTC is rewritten
+    mRtcOffsetUs = offsetUs;
+    mIsRtcWritePending = mCalibrator.addSample(time(nullptr), offsetUs);
+}
+
+int64_t ClockDiscipline::getRemainingSlewUs() {
+    struct timeval remaining = {};
+    adjtime(nullptr, &remaining);
+    return remaining.tv_sec * kUsPerSecond + remaining.tv_usec;
+}
+
+bool ClockDiscipline::writeRtc() {
+    // Writing the seconds register restarts the RTC second, so the RTC
+    // phase follows the system clock up to the tick and I2C latency
+    time_t now = time(nullptr);
+    struct tm utcTime;
+    gmtime_r(&now, &utcTime);
+    if (!mRtc.setTime(&utcTime)) {
+        ESP_LOGE(kTag, "Failed to set RTC time");
+        return false;
+    }
+    ESP_LOGI(kTag, "RTC set to the synchronized system time");
+    return true;
+}
@@ -0,0 +1,116 @@
+/******************************************************************************
+ * File:    config_record.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Implements the binary config record encoding
+ ******************************************************************************/
+
+#include "config_record.h"
+
+#include <cstring>
+
+RecordWriter::RecordWriter(uint8_t* data, size_t capacity)
+    : mData(data), mCapacity(capacity), mSize(0), mIsOverrun(false) {}
+
+void RecordWriter::putU8(uint8_t value) {
+    uint8_t* bytes = take(1);
+    if (bytes) {
+        bytes[0] = value;
+    }
+}
+
+void RecordWriter::putU16(uint16_t value) {
+    putU8(value & 0xFF);
+    putU8(value >> 8);
+}
+
+void RecordWriter::putU32(uint32_t value) {
+    putU16(value & 0xFFFF);
+    putU16(value >> 16);
+}
+
+void RecordWriter::putString(const char* value) {
+    putBytes(reinterpret_cast<const uint8_t*>(value), strlen(value));
+}
+
+void RecordWriter::putBytes(const uint8_t* data, size_t size) {
+    putU16(size);
+    uint8_t* bytes = take(size);
+    if (bytes) {
+        memcpy(bytes, data, size);
+    }
+}
+
+size_t RecordWriter::getSize() const { return mSize; }
+
+bool RecordWriter::isValid() const { return !mIsOverrun; }
+
+uint8_t* RecordWriter::take(size_t size) {
+    if (mIsOverrun || size > mCapacity - mSize) {
+        mIsOverrun = true;
+        return nullptr;
+    }
+    uint8_t* bytes = mData + mSize;
+    mSize += size;
+    return bytes;
+}
+
+RecordReader::RecordReader(const uint8_t* data, size_t size)
+    : mData(data), mSize(size), mPosition(0), mIsOverrun(false) {}
+
+uint8_t RecordReader::getU8() {
+    const uint8_t* bytes = take(1);
+    return bytes ? bytes[0] : 0;
+}
+
+uint16_t RecordReader::getU16() {
+    const uint8_t* bytes = take(2);
+    return bytes ? bytes[0] | (bytes[1] << 8) : 0;
+}
+
+uint32_t RecordReader::getU32() {
+    const uint8_t* bytes = take(4);
+    return bytes ? bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) |
+                       (static_cast<uint32_t>(bytes[3]) << 24)
+                 : 0;
+}
+
+void RecordReader::getString(char* value, size_t size) {
+    uint16_t length = getU16();
+    const uint8_t* bytes = take(length);
+    if (bytes && length >= size) {
+        mIsOverrun = true;
+        bytes = nullptr;
+    }
+    if (bytes) {
+        memcpy(value, bytes, length);
+        value[length] = '\0';
+    } else if (size > 0) {
+        value[0] = '\0';
+    }
+}
+
+const uint8_t* RecordReader::getBytes(size_t& size) {
+    uint16_t length = getU16();
+    const uint8_t* bytes = take(length);
+    size = bytes ? length : 0;
+    return bytes;
+}
+
+size_t RecordReader::getRemaining() const {
+    return mIsOverrun ? 0 : mSize - mPosition;
+}
+
+bool RecordReader::isValid() const {
+    return !mIsOverrun && mPosition == mSize;
+}
+
+const uint8_t* RecordReader::take(size_t size) {
+    if (mIsOverrun || size > mSize - mPosition) {
+        mIsOverrun = true;
+        return nullptr;
+    }
+    const uint8_t* bytes = mData + mPosition;
+    mPosition += size;
+    return bytes;
+}
@@ -8,34 +8,427 @@
 
 #include "config_store.h"
 
-#include <filesystem>
-#include <fstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <inttypes.h>
-#include <iostream>
 #include <mutex>
-#include <sstream>
+
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "cJSON.h"
+#include "config_bus.h"
+#include "config_record.h"
 #include "esp_littlefs.h"
 #include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "freertos/task.h"
 
 static const char* kTag = "config_store";
-static constexpr const char* kLedInfoFile = "/littlefs/config/led_info.json";
+static constexpr const char* kLedInfoFile = "/littlefs/config/led_info.bin";
 static constexpr const char* kSleepInfoFile =
+    "/littlefs/config/sleep_info.bin";
+static constexpr const char* kTimeInfoFile = "/littlefs/config/time_info.bin";
+static constexpr const char* kWifiInfoFile = "/littlefs/config/wifi_info.bin";
+static constexpr const char* kCalibrationInfoFile =
+    "/littlefs/config/calibration_info.bin";
+// JSON files of older firmware, migrated to records on first boot
+static constexpr const char* kLedInfoJsonFile =
+    "/littlefs/config/led_info.json";
+static constexpr const char* kSleepInfoJsonFile =
     "/littlefs/config/sleep_info.json";
-static constexpr const char* kTimeInfoFile = "/littlefs/config/time_info.json";
-static constexpr const char* kWifiInfoFile = "/littlefs/config/wifi_info.json";
+static constexpr const char* kTimeInfoJsonFile =
+    "/littlefs/config/time_info.json";
+static constexpr const char* kWifiInfoJsonFile =
+    "/littlefs/config/wifi_info.json";
+static constexpr const char* kCalibrationInfoJsonFile =
+    "/littlefs/config/calibration_info.json";
+static constexpr const char* kTempSuffix = ".tmp";
+static constexpr size_t kMaxPathLength = 64;
+
+// bumped whenever the payload layout of the section changes
+static constexpr uint16_t kLedInfoVersion = 1;
+static constexpr uint16_t kSleepInfoVersion = 1;
+static constexpr uint16_t kWifiInfoVersion = 1;
+static constexpr uint16_t kTimeInfoVersion = 1;
+static constexpr uint16_t kCalibrationInfoVersion = 1;
+
+static constexpr const char* kJournalFile = "/littlefs/config/journal.bin";
+static constexpr uint16_t kJournalVersion = 1;
+// section and payload length in front of every payload of the journal
+static constexpr size_t kJournalEntryHeaderLength = 3;
+
+// Largest payload of a section, a TimeInfo with all NTP servers. The info
+// classes bound their strings, so an encoded section always fits.
+static constexpr size_t kMaxPayloadLength =
+    2 + TimeInfo::kTzZoneSize + 2 + TimeInfo::kTzOffsetSize + 1 + 1 +
+    TimeInfo::kMaxNtpServers * (2 + TimeInfo::kNtpServerSize);
+static_assert(2 + WifiInfo::kHostnameSize + 2 + WifiInfo::kSsidSize + 1 + 2 +
+                      WifiInfo::kPasswordSize <=
+                  kMaxPayloadLength,
+              "WifiInfo payload does not fit kMaxPayloadLength");
+
+/**
+ * @brief Config sections, bit n of the dirty mask belongs to section n
+ */
+enum Section : uint8_t {
+    kLedInfoSection,
+    kSleepInfoSection,
+    kWifiInfoSection,
+    kTimeInfoSection,
+    kCalibrationInfoSection,
+    kSectionCount
+};
+
+/**
+ * @brief Record file of a section
+ */
+struct SectionRecord {
+    const char* path;
+    uint16_t version;
+};
+
+static constexpr SectionRecord kSectionRecords[kSectionCount] = {
+    {kLedInfoFile, kLedInfoVersion},
+    {kSleepInfoFile, kSleepInfoVersion},
+    {kWifiInfoFile, kWifiInfoVersion},
+    {kTimeInfoFile, kTimeInfoVersion},
+    {kCalibrationInfoFile, kCalibrationInfoVersion}};
+
+// saves are written once no other save came within kFlushDelay, but a
+// continuous stream of saves is written at least every kMaxFlushDelay
+static constexpr TickType_t kFlushDelay = pdMS_TO_TICKS(2000);
+static constexpr TickType_t kMaxFlushDelay = pdMS_TO_TICKS(10000);
+static constexpr uint32_t kFlushTaskStackSize = 4096;
 
 Mutex ConfigStore::mMutex;
+Mutex ConfigStore::mFlushMutex;
 bool ConfigStore::mIsInitialized = false;
+TaskHandle_t ConfigStore::mFlushTaskHandle = nullptr;
+uint32_t ConfigStore::mDirtySections = 0;
+ConfigStoreStats ConfigStore::mStats = {};
+std::optional<LedInfo> ConfigStore::mLedInfo;
+std::optional<SleepInfo> ConfigStore::mSleepInfo;
+std::optional<WifiInfo> ConfigStore::mWifiInfo;
+std::optional<TimeInfo> ConfigStore::mTimeInfo;
+std::optional<CalibrationInfo> ConfigStore::mCalibrationInfo;
+
+// Config files are read into this buffer and parsed in place, so loading a
+// section needs no heap. Files are only read by initialize() under mMutex.
+static uint8_t gBuffer[2048];
+
+// Sections are encoded into this buffer, laid out as the journal payload:
+// section, payload length and payload for every section. The records are
+// written from the same bytes. Used by flush() under mFlushMutex, and by the
+// migration in initialize() before the flush task starts.
+static uint8_t gFlushBuffer[kSectionCount * (kJournalEntryHeaderLength +
+                                             kMaxPayloadLength)];
+static_assert(sizeof(gFlushBuffer) < sizeof(gBuffer) - sizeof(RecordHeader),
+              "the journal has to fit the read buffer");
+
+/**
+ * @brief Read a whole file into gBuffer
+ *
+ * One byte of gBuffer is kept free for the terminator of JSON content.
+ *
+ * @param path file path
+ * @return file length, -1 if the file is missing, unreadable or too large
+ */
+static ssize_t readFile(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+    size_t length = 0;
+    ssize_t count;
+    while ((count = read(fd, gBuffer + length, sizeof(gBuffer) - length)) >
+           0) {
+        length += count;
+    }
+    close(fd);
+    if (count < 0 || length == sizeof(gBuffer)) {
+        ESP_LOGE(kTag, "Failed to read %s", path);
+        return -1;
+    }
+    return length;
+}
+
+/**
+ * @brief Check a record read into gBuffer
+ *
+ * @param size record file size, negative if it could not be read
+ * @param version expected payload version
+ * @param length payload length
+ * @return payload inside gBuffer, nullptr if the record is not intact
+ */
+static const uint8_t* decodeRecord(ssize_t size, uint16_t version,
+                                   size_t& length) {
+    RecordHeader header;
+    if (size < static_cast<ssize_t>(sizeof(header))) {
+        return nullptr;
+    }
+    memcpy(&header, gBuffer, sizeof(header));
+    if (header.magic != kRecordMagic || header.version != version ||
+        header.length != size - sizeof(header)) {
+        return nullptr;
+    }
+    const uint8_t* payload = gBuffer + sizeof(header);
+    if (esp_rom_crc32_le(0, payload, header.length) != header.crc) {
+        return nullptr;
+    }
+    length = header.length;
+    return payload;
+}
+
+/**
+ * @brief Serialize led info into a record payload
+ *
+ * @param ledInfo led info
+ * @param payload buffer of kMaxPayloadLength bytes
+ * @return payload length
+ */
+static size_t encodeLedInfo(const LedInfo& ledInfo, uint8_t* payload) {
+    RecordWriter writer(payload, kMaxPayloadLength);
+    writer.putU8(ledInfo.getRed());
+    writer.putU8(ledInfo.getGreen());
+    writer.putU8(ledInfo.getBlue());
+    writer.putU8(static_cast<uint8_t>(ledInfo.getState()));
+    return writer.getSize();
+}
+
+/**
+ * @brief Serialize sleep info into a record payload
+ *
+ * @param sleepInfo sleep info
+ * @param payload buffer of kMaxPayloadLength bytes
+ * @return payload length
+ */
+static size_t encodeSleepInfo(const SleepInfo& sleepInfo, uint8_t* payload) {
+    RecordWriter writer(payload, kMaxPayloadLength);
+    writer.putU16(sleepInfo.getSleepBefore());
+    writer.putU16(sleepInfo.getSleepAfter());
+    return writer.getSize();
+}
+
+/**
+ * @brief Serialize wifi info into a record payload
+ *
+ * @param wifiInfo wifi info
+ * @param payload buffer of kMaxPayloadLength bytes
+ * @return payload length
+ */
+static size_t encodeWifiInfo(const WifiInfo& wifiInfo, uint8_t* payload) {
+    RecordWriter writer(payload, kMaxPayloadLength);
+    writer.putString(wifiInfo.getHostname());
+    writer.putString(wifiInfo.getSSID());
+    writer.putU8(static_cast<uint8_t>(wifiInfo.getAuthType()));
+    writer.putString(wifiInfo.getPassword());
+    return writer.getSize();
+}
+
+/**
+ * @brief Serialize time info into a record payload
+ *
+ * @param timeInfo time info
+ * @param payload buffer of kMaxPayloadLength bytes
+ * @return payload length
+ */
+static size_t encodeTimeInfo(const TimeInfo& timeInfo, uint8_t* payload) {
+    RecordWriter writer(payload, kMaxPayloadLength);
+    writer.putString(timeInfo.getTzZone());
+    writer.putString(timeInfo.getTzOffset());
+    writer.putU8(static_cast<uint8_t>(timeInfo.getTimeFormat()));
+    writer.putU8(timeInfo.getNtpServerCount());
+    for (uint8_t i = 0; i < timeInfo.getNtpServerCount(); ++i) {
+        writer.putString(timeInfo.getNtpServer(i));
+    }
+    return writer.getSize();
+}
+
+/**
+ * @brief Serialize calibration info into a record payload
+ *
+ * @param calibrationInfo calibration info
+ * @param payload buffer of kMaxPayloadLength bytes
+ * @return payload length
+ */
+static size_t encodeCalibrationInfo(const CalibrationInfo& calibrationInfo,
+                                    uint8_t* payload) {
+    RecordWriter writer(payload, kMaxPayloadLength);
+    writer.putU8(calibrationInfo.getAgingOffset());
+    writer.putU32(calibrationInfo.getDriftPpb());
+    writer.putU32(calibrationInfo.getSyncInterval());
+    return writer.getSize();
+}
+
+/**
+ * @brief Read a section, migrating it from its JSON file on first boot
+ *
+ * @param read reads the record of the section
+ * @param readJson reads the JSON file of the section
+ * @param write writes the record of the section
+ * @param jsonPath path of the JSON file, removed after the migration
+ * @return section info if it is stored
+ */
+template <typename T>
+static std::optional<T> readSection(std::optional<T> (*read)(),
+                                    std::optional<T> (*readJson)(),
+                                    bool (*write)(const T&),
+                                    const char* jsonPath) {
+    std::optional<T> info = read();
+    if (info.has_value()) {
+        return info;
+    }
+    info = readJson();
+    if (info.has_value() && write(*info)) {
+        std::remove(jsonPath);
+        ESP_LOGI(kTag, "Migrated %s", jsonPath);
+    }
+    return info;
+}
 
 void ConfigStore::initialize() {
+    std::lock_guard<Mutex> lock(mMutex);
     if (!mIsInitialized) {
         setupLittlefs();
+        replayJournal();
+        // every section is read once, later loads are served from RAM
+        mLedInfo = readSection(readLedInfo, readLedInfoJson, writeLedInfo,
+                               kLedInfoJsonFile);
+        mSleepInfo = readSection(readSleepInfo, readSleepInfoJson,
+                                 writeSleepInfo, kSleepInfoJsonFile);
+        mWifiInfo = readSection(readWifiInfo, readWifiInfoJson, writeWifiInfo,
+                                kWifiInfoJsonFile);
+        mTimeInfo = readSection(readTimeInfo, readTimeInfoJson, writeTimeInfo,
+                                kTimeInfoJsonFile);
+        mCalibrationInfo =
+            readSection(readCalibrationInfo, readCalibrationInfoJson,
+                        writeCalibrationInfo, kCalibrationInfoJsonFile);
+        xTaskCreate(flushTask, "configFlush", kFlushTaskStackSize, nullptr, 1,
+                    &mFlushTaskHandle);
         mIsInitialized = true;
     }
 }
 
+bool ConfigStore::flush() {
+    // serializes the flush task with callers which need the data on flash
+    std::lock_guard<Mutex> flushLock(mFlushMutex);
+    uint32_t sections;
+    const uint8_t* payloads[kSectionCount] = {};
+    size_t lengths[kSectionCount] = {};
+    size_t journalLength = 0;
+    {
+        std::lock_guard<Mutex> lock(mMutex);
+        if (!mIsInitialized) {
+            ESP_LOGE(kTag,
+                     "Module not initialized, intitialize it before using it.");
+            return false;
+        }
+        sections = mDirtySections;
+        mDirtySections = 0;
+        for (uint8_t section = 0; section < kSectionCount; ++section) {
+            if (sections & (1u << section)) {
+                uint8_t* entry = gFlushBuffer + journalLength;
+                payloads[section] = entry + kJournalEntryHeaderLength;
+                lengths[section] =
+                    encodeSection(section, entry + kJournalEntryHeaderLength);
+                RecordWriter writer(entry, kJournalEntryHeaderLength);
+                writer.putU8(section);
+                writer.putU16(lengths[section]);
+                journalLength += kJournalEntryHeaderLength + lengths[section];
+            }
+        }
+    }
+    if (sections == 0) {
+        return true;
+    }
+    // Files are written without holding mMutex, loads and saves go on. More
+    // sections are committed together to the journal first, a power loss
+    // while writing their records is then repaired on the next boot.
+    uint32_t failed = 0;
+    bool isJournaled = __builtin_popcount(sections) > 1;
+    if (isJournaled && !writeRecord(kJournalFile, kJournalVersion,
+                                    gFlushBuffer, journalLength)) {
+        failed = sections;
+    } else {
+        for (uint8_t section = 0; section < kSectionCount; ++section) {
+            const SectionRecord& record = kSectionRecords[section];
+            if ((sections & (1u << section)) &&
+                !writeRecord(record.path, record.version, payloads[section],
+                             lengths[section])) {
+                failed |= 1u << section;
+            }
+        }
+        if (isJournaled) {
+            // failed sections stay in RAM and are retried, the journal would
+            // overwrite their next successful write on boot
+            std::remove(kJournalFile);
+        }
+    }
+    std::lock_guard<Mutex> lock(mMutex);
+    // failed sections stay dirty and are retried with the next flush
+    mDirtySections |= failed;
+    mStats.writeCount += __builtin_popcount(sections & ~failed);
+    mStats.failedCount += __builtin_popcount(failed);
+    ESP_LOGI(kTag,
+             "Flushed %d sections, %" PRIu32 " of %" PRIu32
+             " saves coalesced since boot",
+             __builtin_popcount(sections & ~failed), mStats.coalescedCount,
+             mStats.saveCount);
+    return failed == 0;
+}
+
+ConfigStoreStats ConfigStore::getStats() {
+    std::lock_guard<Mutex> lock(mMutex);
+    ConfigStoreStats stats = mStats;
+    stats.pendingCount = __builtin_popcount(mDirtySections);
+    return stats;
+}
+
+bool ConfigStore::saveConfig(const DeviceConfig& config) {
+    {
+        std::lock_guard<Mutex> lock(mMutex);
+        if (!mIsInitialized) {
+            ESP_LOGE(kTag,
+                     "Module not initialized, intitialize it before using it.");
+            return false;
+        }
+        if (config.ledInfo.has_value()) {
+            mLedInfo = config.ledInfo;
+            markDirty(kLedInfoSection);
+        }
+        if (config.sleepInfo.has_value()) {
+            mSleepInfo = config.sleepInfo;
+            markDirty(kSleepInfoSection);
+        }
+        if (config.timeInfo.has_value()) {
+            mTimeInfo = config.timeInfo;
+            markDirty(kTimeInfoSection);
+        }
+        if (config.wifiInfo.has_value()) {
+            mWifiInfo = config.wifiInfo;
+            markDirty(kWifiInfoSection);
+        }
+    }
+    // one commit for all sections instead of waiting for the flush task
+    bool isFlushed = flush();
+    if (config.ledInfo.has_value()) {
+        ConfigBus::publish(*config.ledInfo);
+    }
+    if (config.sleepInfo.has_value()) {
+        ConfigBus::publish(*config.sleepInfo);
+    }
+    if (config.timeInfo.has_value()) {
+        ConfigBus::publish(*config.timeInfo);
+    }
+    // last, a wifi change restarts the clock
+    if (config.wifiInfo.has_value()) {
+        ConfigBus::publish(*config.wifiInfo);
+    }
+    return isFlushed;
+}
+
 std::optional<LedInfo> ConfigStore::loadLedInfo() {
     std::lock_guard<Mutex> lock(mMutex);
     if (!mIsInitialized) {
@@ -43,15 +436,129 @@ std::optional<LedInfo> ConfigStore::loadLedInfo() {
                  "Module not initialized, intitialize it before using it.");
         return std::nullopt;
     }
-    // check if file exists on kLedInfoFile path
-    if (!std::filesystem::exists(kLedInfoFile)) {
+    return mLedInfo;
+}
+
+bool ConfigStore::saveLedInfo(const LedInfo& ledInfo) {
+    {
+        std::lock_guard<Mutex> lock(mMutex);
+        if (!mIsInitialized) {
+            ESP_LOGE(kTag,
+                     "Module not initialized, intitialize it before using it.");
+            return false;
+        }
+        mLedInfo = ledInfo;
+        markDirty(kLedInfoSection);
+    }
+    ConfigBus::publish(ledInfo);
+    return true;
+}
+
+std::optional<SleepInfo> ConfigStore::loadSleepInfo() {
+    std::lock_guard<Mutex> lock(mMutex);
+    if (!mIsInitialized) {
+        ESP_LOGE(kTag,
+                 "Module not initialized, intitialize it before using it.");
+        return std::nullopt;
+    }
+    return mSleepInfo;
+}
+
+bool ConfigStore::saveSleepInfo(const SleepInfo& sleepInfo) {
+    {
+        std::lock_guard<Mutex> lock(mMutex);
+        if (!mIsInitialized) {
+            ESP_LOGE(kTag,
+                     "Module not initialized, intitialize it before using it.");
+            return false;
+        }
+        mSleepInfo = sleepInfo;
+        markDirty(kSleepInfoSection);
+    }
+    ConfigBus::publish(sleepInfo);
+    return true;
+}
+
+std::optional<WifiInfo> ConfigStore::loadWifiInfo() {
+    std::lock_guard<Mutex> lock(mMutex);
+    if (!mIsInitialized) {
+        ESP_LOGE(kTag,
+                 "Module not initialized, intitialize it before using it.");
+        return std::nullopt;
+    }
+    return mWifiInfo;
+}
+
+bool ConfigStore::saveWifiInfo(const WifiInfo& wifiInfo) {
+    {
+        std::lock_guard<Mutex> lock(mMutex);
+        if (!mIsInitialized) {
+            ESP_LOGE(kTag,
+                     "Module not initialized, intitialize it before using it.");
+            return false;
+        }
+        mWifiInfo = wifiInfo;
+        markDirty(kWifiInfoSection);
+    }
+    ConfigBus::publish(wifiInfo);
+    return true;
+}
+
+std::optional<TimeInfo> ConfigStore::loadTimeInfo() {
+    std::lock_guard<Mutex> lock(mMutex);
+    if (!mIsInitialized) {
+        ESP_LOGE(kTag,
+                 "Module not initialized, intitialize it before using it.");
+        return std::nullopt;
+    }
+    return mTimeInfo;
+}
+
+bool ConfigStore::saveTimeInfo(const TimeInfo& timeInfo) {
+    {
+        std::lock_guard<Mutex> lock(mMutex);
+        if (!mIsInitialized) {
+            ESP_LOGE(kTag,
+                     "Module not initialized, intitialize it before using it.");
+            return false;
+        }
+        mTimeInfo = timeInfo;
+        markDirty(kTimeInfoSection);
+    }
+    ConfigBus::publish(timeInfo);
+    return true;
+}
+
+std::optional<CalibrationInfo> ConfigStore::loadCalibrationInfo() {
+    std::lock_guard<Mutex> lock(mMutex);
+    if (!mIsInitialized) {
+        ESP_LOGE(kTag,
+                 "Module not initialized, intitialize it before using it.");
+        return std::nullopt;
+    }
+    return mCalibrationInfo;
+}
+
+bool ConfigStore::saveCalibrationInfo(const CalibrationInfo& calibrationInfo) {
+    {
+        std::lock_guard<Mutex> lock(mMutex);
+        if (!mIsInitialized) {
+            ESP_LOGE(kTag,
+                     "Module not initialized, intitialize it before using it.");
+            return false;
+        }
+        mCalibrationInfo = calibrationInfo;
+        markDirty(kCalibrationInfoSection);
+    }
+    ConfigBus::publish(calibrationInfo);
+    return true;
+}
+
+std::optional<LedInfo> ConfigStore::readLedInfoJson() {
+    cJSON* json = readJson(kLedInfoJsonFile);
+    if (json == nullptr) {
         return std::nullopt;
     }
-    // read and parse JSON file
-    std::stringstream buffer;
-    std::ifstream ledInfoFile(kLedInfoFile);
-    buffer << ledInfoFile.rdbuf();
-    cJSON* json = cJSON_Parse(buffer.str().c_str());
     // check are all fields present in the config
     if (!cJSON_GetObjectItemCaseSensitive(json, "R")) {
         ESP_LOGW(kTag, "'R' is not found in config");
@@ -88,48 +595,11 @@ std::optional<LedInfo> ConfigStore::loadLedInfo() {
     return ledInfo;
 }
 
-bool ConfigStore::saveLedInfo(const LedInfo& ledInfo) {
-    std::lock_guard<Mutex> lock(mMutex);
-    if (!mIsInitialized) {
-        ESP_LOGE(kTag,
-                 "Module not initialized, intitialize it before using it.");
-        return false;
-    }
-    cJSON* json = cJSON_CreateObject();
-    cJSON_AddItemToObject(json, "R", cJSON_CreateNumber(ledInfo.getRed()));
-    cJSON_AddItemToObject(json, "G", cJSON_CreateNumber(ledInfo.getGreen()));
-    cJSON_AddItemToObject(json, "B", cJSON_CreateNumber(ledInfo.getBlue()));
-    cJSON_AddItemToObject(
-        json, "state",
-        cJSON_CreateString(ledStateToString(ledInfo.getState())));
-    char* jsonString = cJSON_Print(json);
-    if (jsonString != nullptr) {
-        std::ofstream ledInfoFile(kLedInfoFile);
-        ledInfoFile << jsonString;
-        cJSON_free(jsonString);
-    }
-    cJSON_Delete(json);
-    return true;
-}
-
-std::optional<SleepInfo> ConfigStore::loadSleepInfo() {
-    std::lock_guard<Mutex> lock(mMutex);
-    if (!mIsInitialized) {
-        ESP_LOGE(kTag,
-                 "Module not initialized, intitialize it before using it.");
-        return std::nullopt;
-    }
-    // check if file exists on kSleepInfoFile path
-    if (!std::filesystem::exists(kSleepInfoFile)) {
+std::optional<SleepInfo> ConfigStore::readSleepInfoJson() {
+    cJSON* json = readJson(kSleepInfoJsonFile);
+    if (json == nullptr) {
         return std::nullopt;
     }
-    // read and parse JSON file
-    std::stringstream buffer;
-    {
-        std::ifstream sleepInfoFile(kSleepInfoFile);
-        buffer << sleepInfoFile.rdbuf();
-    }
-    cJSON* json = cJSON_Parse(buffer.str().c_str());
     // check are all fields present in the config
     if (!cJSON_GetObjectItemCaseSensitive(json, "sleep_before")) {
         ESP_LOGW(kTag, "'sleep_before' is not found in config");
@@ -151,44 +621,11 @@ std::optional<SleepInfo> ConfigStore::loadSleepInfo() {
     return sleepInfo;
 }
 
-bool ConfigStore::saveSleepInfo(const SleepInfo& sleepInfo) {
-    std::lock_guard<Mutex> lock(mMutex);
-    if (!mIsInitialized) {
-        ESP_LOGE(kTag,
-                 "Module not initialized, intitialize it before using it.");
-        return false;
-    }
-    cJSON* json = cJSON_CreateObject();
-    cJSON_AddItemToObject(json, "sleep_before",
-                          cJSON_CreateNumber(sleepInfo.getSleepBefore()));
-    cJSON_AddItemToObject(json, "sleep_after",
-                          cJSON_CreateNumber(sleepInfo.getSleepAfter()));
-    char* jsonString = cJSON_Print(json);
-    if (jsonString != nullptr) {
-        std::ofstream sleepInfoFile(kSleepInfoFile);
-        sleepInfoFile << jsonString;
-        cJSON_free(jsonString);
-    }
-    cJSON_Delete(json);
-    return true;
-}
-
-std::optional<WifiInfo> ConfigStore::loadWifiInfo() {
-    std::lock_guard<Mutex> lock(mMutex);
-    if (!mIsInitialized) {
-        ESP_LOGE(kTag,
-                 "Module not initialized, intitialize it before using it.");
-        return std::nullopt;
-    }
-    // check if file exists on kWifiInfoFile path
-    if (!std::filesystem::exists(kWifiInfoFile)) {
+std::optional<WifiInfo> ConfigStore::readWifiInfoJson() {
+    cJSON* json = readJson(kWifiInfoJsonFile);
+    if (json == nullptr) {
         return std::nullopt;
     }
-    // read and parse JSON file
-    std::stringstream buffer;
-    std::ifstream wifiInfoFile(kWifiInfoFile);
-    buffer << wifiInfoFile.rdbuf();
-    cJSON* json = cJSON_Parse(buffer.str().c_str());
     // check are all fields present in the config
     if (!cJSON_GetObjectItemCaseSensitive(json, "hostname")) {
         ESP_LOGW(kTag, "'hostname' is not found in config");
@@ -212,10 +649,16 @@ std::optional<WifiInfo> ConfigStore::loadWifiInfo() {
     }
     // populate WifiInfo object
     WifiInfo wifiInfo;
-    wifiInfo.setHostname(
-        cJSON_GetObjectItemCaseSensitive(json, "hostname")->valuestring);
-    wifiInfo.setSSID(
-        cJSON_GetObjectItemCaseSensitive(json, "SSID")->valuestring);
+    if (!wifiInfo.setHostname(
+            cJSON_GetObjectItemCaseSensitive(json, "hostname")->valuestring) ||
+        !wifiInfo.setSSID(
+            cJSON_GetObjectItemCaseSensitive(json, "SSID")->valuestring) ||
+        !wifiInfo.setPassword(
+            cJSON_GetObjectItemCaseSensitive(json, "password")->valuestring)) {
+        ESP_LOGW(kTag, "Too long 'hostname', 'SSID' or 'password'");
+        cJSON_Delete(json);
+        return std::nullopt;
+    }
     std::string authType =
         cJSON_GetObjectItemCaseSensitive(json, "auth_type")->valuestring;
     if (authType == "open") {
@@ -229,55 +672,15 @@ std::optional<WifiInfo> ConfigStore::loadWifiInfo() {
         cJSON_Delete(json);
         return std::nullopt;
     }
-    wifiInfo.setPassword(
-        cJSON_GetObjectItemCaseSensitive(json, "password")->valuestring);
     cJSON_Delete(json);
     return wifiInfo;
 }
 
-bool ConfigStore::saveWifiInfo(const WifiInfo& wifiInfo) {
-    std::lock_guard<Mutex> lock(mMutex);
-    if (!mIsInitialized) {
-        ESP_LOGE(kTag,
-                 "Module not initialized, intitialize it before using it.");
-        return false;
-    }
-    cJSON* json = cJSON_CreateObject();
-    cJSON_AddItemToObject(json, "hostname",
-                          cJSON_CreateString(wifiInfo.getHostname().c_str()));
-    cJSON_AddItemToObject(json, "SSID",
-                          cJSON_CreateString(wifiInfo.getSSID().c_str()));
-    cJSON_AddItemToObject(
-        json, "auth_type",
-        cJSON_CreateString(wifiAuthTypeToString(wifiInfo.getAuthType())));
-    cJSON_AddItemToObject(json, "password",
-                          cJSON_CreateString(wifiInfo.getPassword().c_str()));
-    char* jsonString = cJSON_Print(json);
-    if (jsonString != nullptr) {
-        std::ofstream wifiInfoFile(kWifiInfoFile);
-        wifiInfoFile << jsonString;
-        cJSON_free(jsonString);
-    }
-    cJSON_Delete(json);
-    return true;
-}
-
-std::optional<TimeInfo> ConfigStore::loadTimeInfo() {
-    std::lock_guard<Mutex> lock(mMutex);
-    if (!mIsInitialized) {
-        ESP_LOGE(kTag,
-                 "Module not initialized, intitialize it before using it.");
-        return std::nullopt;
-    }
-    // check if file exists on kTimeInfoFile path
-    if (!std::filesystem::exists(kTimeInfoFile)) {
+std::optional<TimeInfo> ConfigStore::readTimeInfoJson() {
+    cJSON* json = readJson(kTimeInfoJsonFile);
+    if (json == nullptr) {
         return std::nullopt;
     }
-    // read and parse JSON file
-    std::stringstream buffer;
-    std::ifstream timeInfoFile(kTimeInfoFile);
-    buffer << timeInfoFile.rdbuf();
-    cJSON* json = cJSON_Parse(buffer.str().c_str());
     // check are all fields present in the config
     if (!cJSON_GetObjectItemCaseSensitive(json, "tz_zone")) {
         ESP_LOGW(kTag, "'tz_zone' is not found in config");
@@ -296,10 +699,14 @@ std::optional<TimeInfo> ConfigStore::loadTimeInfo() {
     }
     // populate TimeInfo object
     TimeInfo timeInfo;
-    timeInfo.setTzZone(
-        cJSON_GetObjectItemCaseSensitive(json, "tz_zone")->valuestring);
-    timeInfo.setTzOffset(
-        cJSON_GetObjectItemCaseSensitive(json, "tz_offset")->valuestring);
+    if (!timeInfo.setTzZone(
+            cJSON_GetObjectItemCaseSensitive(json, "tz_zone")->valuestring) ||
+        !timeInfo.setTzOffset(
+            cJSON_GetObjectItemCaseSensitive(json, "tz_offset")->valuestring)) {
+        ESP_LOGW(kTag, "Too long 'tz_zone' or 'tz_offset'");
+        cJSON_Delete(json);
+        return std::nullopt;
+    }
     std::string timeFormat =
         cJSON_GetObjectItemCaseSensitive(json, "time_format")->valuestring;
     if (timeFormat == "24h") {
@@ -311,32 +718,346 @@ std::optional<TimeInfo> ConfigStore::loadTimeInfo() {
         cJSON_Delete(json);
         return std::nullopt;
     }
+    // optional, older configs do not have it
+    cJSON* ntpServersJson =
+        cJSON_GetObjectItemCaseSensitive(json, "ntp_servers");
+    if (cJSON_IsArray(ntpServersJson)) {
+        // servers which do not fit are dropped
+        TimeInfo serversInfo = timeInfo;
+        serversInfo.clearNtpServers();
+        cJSON* server = nullptr;
+        cJSON_ArrayForEach(server, ntpServersJson) {
+            if (cJSON_IsString(server)) {
+                serversInfo.addNtpServer(server->valuestring);
+            }
+        }
+        if (serversInfo.getNtpServerCount() > 0) {
+            timeInfo = serversInfo;
+        }
+    }
     cJSON_Delete(json);
     return timeInfo;
 }
 
-bool ConfigStore::saveTimeInfo(const TimeInfo& timeInfo) {
-    std::lock_guard<Mutex> lock(mMutex);
-    if (!mIsInitialized) {
-        ESP_LOGE(kTag,
-                 "Module not initialized, intitialize it before using it.");
-        return false;
+std::optional<CalibrationInfo> ConfigStore::readCalibrationInfoJson() {
+    cJSON* json = readJson(kCalibrationInfoJsonFile);
+    if (json == nullptr) {
+        return std::nullopt;
     }
-    cJSON* json = cJSON_CreateObject();
-    cJSON_AddItemToObject(json, "tz_zone",
-                          cJSON_CreateString(timeInfo.getTzZone().c_str()));
-    cJSON_AddItemToObject(json, "tz_offset",
-                          cJSON_CreateString(timeInfo.getTzOffset().c_str()));
-    cJSON_AddItemToObject(
-        json, "time_format",
-        cJSON_CreateString(timeFormatToString(timeInfo.getTimeFormat())));
-    char* jsonString = cJSON_Print(json);
-    if (jsonString != nullptr) {
-        std::ofstream timeInfoFile(kTimeInfoFile);
-        timeInfoFile << jsonString;
-        cJSON_free(jsonString);
+    // check are all fields present in the config
+    if (!cJSON_GetObjectItemCaseSensitive(json, "aging_offset")) {
+        ESP_LOGW(kTag, "'aging_offset' is not found in config");
+        cJSON_Delete(json);
+        return std::nullopt;
     }
+    if (!cJSON_GetObjectItemCaseSensitive(json, "drift_ppb")) {
+        ESP_LOGW(kTag, "'drift_ppb' is not found in config");
+        cJSON_Delete(json);
+        return std::nullopt;
+    }
+    if (!cJSON_GetObjectItemCaseSensitive(json, "sync_interval")) {
+        ESP_LOGW(kTag, "'sync_interval' is not found in config");
+        cJSON_Delete(json);
+        return std::nullopt;
+    }
+    // populate CalibrationInfo object
+    CalibrationInfo calibrationInfo;
+    calibrationInfo.setAgingOffset(
+        cJSON_GetObjectItemCaseSensitive(json, "aging_offset")->valueint);
+    calibrationInfo.setDriftPpb(
+        cJSON_GetObjectItemCaseSensitive(json, "drift_ppb")->valueint);
+    calibrationInfo.setSyncInterval(
+        cJSON_GetObjectItemCaseSensitive(json, "sync_interval")->valueint);
     cJSON_Delete(json);
+    return calibrationInfo;
+}
+
+std::optional<LedInfo> ConfigStore::readLedInfo() {
+    size_t length;
+    const uint8_t* payload = readRecord(kLedInfoFile, kLedInfoVersion, length);
+    if (payload == nullptr) {
+        return std::nullopt;
+    }
+    RecordReader reader(payload, length);
+    LedInfo ledInfo;
+    ledInfo.setRed(reader.getU8());
+    ledInfo.setGreen(reader.getU8());
+    ledInfo.setBlue(reader.getU8());
+    uint8_t state = reader.getU8();
+    if (!reader.isValid() || state > static_cast<uint8_t>(LedState::Pulse)) {
+        ESP_LOGW(kTag, "Invalid record %s", kLedInfoFile);
+        return std::nullopt;
+    }
+    ledInfo.setState(static_cast<LedState>(state));
+    return ledInfo;
+}
+
+bool ConfigStore::writeLedInfo(const LedInfo& ledInfo) {
+    const SectionRecord& record = kSectionRecords[kLedInfoSection];
+    size_t length = encodeLedInfo(ledInfo, gFlushBuffer);
+    return writeRecord(record.path, record.version, gFlushBuffer, length);
+}
+
+std::optional<SleepInfo> ConfigStore::readSleepInfo() {
+    size_t length;
+    const uint8_t* payload =
+        readRecord(kSleepInfoFile, kSleepInfoVersion, length);
+    if (payload == nullptr) {
+        return std::nullopt;
+    }
+    RecordReader reader(payload, length);
+    SleepInfo sleepInfo;
+    sleepInfo.setSleepBefore(reader.getU16());
+    sleepInfo.setSleepAfter(reader.getU16());
+    if (!reader.isValid()) {
+        ESP_LOGW(kTag, "Invalid record %s", kSleepInfoFile);
+        return std::nullopt;
+    }
+    return sleepInfo;
+}
+
+bool ConfigStore::writeSleepInfo(const SleepInfo& sleepInfo) {
+    const SectionRecord& record = kSectionRecords[kSleepInfoSection];
+    size_t length = encodeSleepInfo(sleepInfo, gFlushBuffer);
+    return writeRecord(record.path, record.version, gFlushBuffer, length);
+}
+
+std::optional<WifiInfo> ConfigStore::readWifiInfo() {
+    size_t length;
+    const uint8_t* payload =
+        readRecord(kWifiInfoFile, kWifiInfoVersion, length);
+    if (payload == nullptr) {
+        return std::nullopt;
+    }
+    RecordReader reader(payload, length);
+    char hostname[WifiInfo::kHostnameSize];
+    char ssid[WifiInfo::kSsidSize];
+    char password[WifiInfo::kPasswordSize];
+    reader.getString(hostname, sizeof(hostname));
+    reader.getString(ssid, sizeof(ssid));
+    uint8_t authType = reader.getU8();
+    reader.getString(password, sizeof(password));
+    if (!reader.isValid() ||
+        authType > static_cast<uint8_t>(WifiAuthType::WPA3)) {
+        ESP_LOGW(kTag, "Invalid record %s", kWifiInfoFile);
+        return std::nullopt;
+    }
+    return WifiInfo(hostname, ssid, static_cast<WifiAuthType>(authType),
+                    password);
+}
+
+bool ConfigStore::writeWifiInfo(const WifiInfo& wifiInfo) {
+    const SectionRecord& record = kSectionRecords[kWifiInfoSection];
+    size_t length = encodeWifiInfo(wifiInfo, gFlushBuffer);
+    return writeRecord(record.path, record.version, gFlushBuffer, length);
+}
+
+std::optional<TimeInfo> ConfigStore::readTimeInfo() {
+    size_t length;
+    const uint8_t* payload =
+        readRecord(kTimeInfoFile, kTimeInfoVersion, length);
+    if (payload == nullptr) {
+        return std::nullopt;
+    }
+    RecordReader reader(payload, length);
+    char tzZone[TimeInfo::kTzZoneSize];
+    char tzOffset[TimeInfo::kTzOffsetSize];
+    reader.getString(tzZone, sizeof(tzZone));
+    reader.getString(tzOffset, sizeof(tzOffset));
+    TimeInfo timeInfo(tzZone, tzOffset);
+    uint8_t timeFormat = reader.getU8();
+    uint8_t ntpServerCount = reader.getU8();
+    if (ntpServerCount > 0) {
+        timeInfo.clearNtpServers();
+    }
+    for (uint8_t i = 0; i < ntpServerCount; ++i) {
+        char server[TimeInfo::kNtpServerSize];
+        reader.getString(server, sizeof(server));
+        timeInfo.addNtpServer(server);
+    }
+    if (!reader.isValid() ||
+        timeFormat > static_cast<uint8_t>(TimeFormat::Hour12) ||
+        ntpServerCount > TimeInfo::kMaxNtpServers) {
+        ESP_LOGW(kTag, "Invalid record %s", kTimeInfoFile);
+        return std::nullopt;
+    }
+    timeInfo.setTimeFormat(static_cast<TimeFormat>(timeFormat));
+    return timeInfo;
+}
+
+bool ConfigStore::writeTimeInfo(const TimeInfo& timeInfo) {
+    const SectionRecord& record = kSectionRecords[kTimeInfoSection];
+    size_t length = encodeTimeInfo(timeInfo, gFlushBuffer);
+    return writeRecord(record.path, record.version, gFlushBuffer, length);
+}
+
+std::optional<CalibrationInfo> ConfigStore::readCalibrationInfo() {
+    size_t length;
+    const uint8_t* payload =
+        readRecord(kCalibrationInfoFile, kCalibrationInfoVersion, length);
+    if (payload == nullptr) {
+        return std::nullopt;
+    }
+    RecordReader reader(payload, length);
+    CalibrationInfo calibrationInfo;
+    calibrationInfo.setAgingOffset(static_cast<int8_t>(reader.getU8()));
+    calibrationInfo.setDriftPpb(static_cast<int32_t>(reader.getU32()));
+    calibrationInfo.setSyncInterval(reader.getU32());
+    if (!reader.isValid()) {
+        ESP_LOGW(kTag, "Invalid record %s", kCalibrationInfoFile);
+        return std::nullopt;
+    }
+    return calibrationInfo;
+}
+
+bool ConfigStore::writeCalibrationInfo(const CalibrationInfo& calibrationInfo) {
+    const SectionRecord& record = kSectionRecords[kCalibrationInfoSection];
+    size_t length = encodeCalibrationInfo(calibrationInfo, gFlushBuffer);
+    return writeRecord(record.path, record.version, gFlushBuffer, length);
+}
+
+size_t ConfigStore::encodeSection(uint8_t section, uint8_t* payload) {
+    switch (section) {
+    case kLedInfoSection:
+        return encodeLedInfo(*mLedInfo, payload);
+    case kSleepInfoSection:
+        return encodeSleepInfo(*mSleepInfo, payload);
+    case kWifiInfoSection:
+        return encodeWifiInfo(*mWifiInfo, payload);
+    case kTimeInfoSection:
+        return encodeTimeInfo(*mTimeInfo, payload);
+    default:
+        return encodeCalibrationInfo(*mCalibrationInfo, payload);
+    }
+}
+
+void ConfigStore::markDirty(uint8_t section) {
+    mStats.saveCount++;
+    if (mDirtySections & (1u << section)) {
+        // the pending write of the section carries this save as well
+        mStats.coalescedCount++;
+    }
+    mDirtySections |= 1u << section;
+    xTaskNotifyGive(mFlushTaskHandle);
+}
+
+void ConfigStore::replayJournal() {
+    size_t length;
+    const uint8_t* journal = readRecord(kJournalFile, kJournalVersion, length);
+    if (journal != nullptr) {
+        // The records of the last commit may be partially written, the
+        // journal holds all of them
+        RecordReader reader(journal, length);
+        uint32_t sections = 0;
+        const uint8_t* payloads[kSectionCount] = {};
+        size_t lengths[kSectionCount] = {};
+        while (reader.getRemaining() > 0) {
+            uint8_t section = reader.getU8();
+            size_t payloadLength;
+            const uint8_t* payload = reader.getBytes(payloadLength);
+            if (section < kSectionCount) {
+                sections |= 1u << section;
+                payloads[section] = payload;
+                lengths[section] = payloadLength;
+            }
+        }
+        if (reader.isValid()) {
+            for (uint8_t section = 0; section < kSectionCount; ++section) {
+                const SectionRecord& record = kSectionRecords[section];
+                if (sections & (1u << section)) {
+                    writeRecord(record.path, record.version,
+                                payloads[section], lengths[section]);
+                }
+            }
+            ESP_LOGW(kTag, "Replayed an interrupted config commit");
+        }
+    }
+    std::remove(kJournalFile);
+}
+
+void ConfigStore::flushTask(void* param) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        // wait until the burst of saves is over
+        TickType_t start = xTaskGetTickCount();
+        TickType_t elapsed;
+        while ((elapsed = xTaskGetTickCount() - start) < kMaxFlushDelay &&
+               ulTaskNotifyTake(pdTRUE, std::min(kFlushDelay,
+                                                 kMaxFlushDelay - elapsed)) >
+                   0) {
+        }
+        flush();
+    }
+}
+
+cJSON* ConfigStore::readJson(const char* path) {
+    ssize_t size = readFile(path);
+    if (size < 0) {
+        return nullptr;
+    }
+    gBuffer[size] = '\0';
+    return cJSON_Parse(reinterpret_cast<const char*>(gBuffer));
+}
+
+const uint8_t* ConfigStore::readRecord(const char* path, uint16_t version,
+                                       size_t& length) {
+    char tempPath[kMaxPathLength];
+    snprintf(tempPath, sizeof(tempPath), "%s%s", path, kTempSuffix);
+    // A write may have been interrupted before the rename. A complete temp
+    // file is newer than the record, so it is rolled forward.
+    const uint8_t* payload =
+        decodeRecord(readFile(tempPath), version, length);
+    if (payload != nullptr && std::rename(tempPath, path) == 0) {
+        ESP_LOGW(kTag, "Recovered %s from an interrupted write", path);
+        return payload;
+    }
+    std::remove(tempPath);
+    ssize_t size = readFile(path);
+    if (size < 0) {
+        return nullptr;
+    }
+    payload = decodeRecord(size, version, length);
+    if (payload == nullptr) {
+        ESP_LOGE(kTag, "Corrupted or unsupported record, ignoring %s", path);
+    }
+    return payload;
+}
+
+bool ConfigStore::writeRecord(const char* path, uint16_t version,
+                              const uint8_t* payload, size_t length) {
+    RecordHeader header = {};
+    // the record has to fit gBuffer to be read back
+    if (length >= sizeof(gBuffer) - sizeof(header)) {
+        ESP_LOGE(kTag, "Record too large for %s", path);
+        return false;
+    }
+    header.magic = kRecordMagic;
+    header.version = version;
+    header.length = length;
+    header.crc = esp_rom_crc32_le(0, payload, length);
+    // The old record stays intact until the new one is complete, LittleFS
+    // replaces the destination of a rename atomically.
+    char tempPath[kMaxPathLength];
+    snprintf(tempPath, sizeof(tempPath), "%s%s", path, kTempSuffix);
+    bool isWritten = false;
+    int fd = open(tempPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+        isWritten =
+            write(fd, &header, sizeof(header)) ==
+                static_cast<ssize_t>(sizeof(header)) &&
+            write(fd, payload, length) == static_cast<ssize_t>(length);
+        isWritten = close(fd) == 0 && isWritten;
+    }
+    if (!isWritten) {
+        ESP_LOGE(kTag, "Failed to write %s", tempPath);
+        std::remove(tempPath);
+        return false;
+    }
+    if (std::rename(tempPath, path) != 0) {
+        ESP_LOGE(kTag, "Failed to rename %s", tempPath);
+        std::remove(tempPath);
+        return false;
+    }
     return true;
 }
 
@@ -0,0 +1,125 @@
+/******************************************************************************
+ * File:    digit_sequencer.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Implements DigitSequencer class
+ ******************************************************************************/
+
+#include "digit_sequencer.h"
+
+#include "bcd_2_decimal_decoder.h"
+
+static constexpr uint32_t kTimerResolution = 1000000;   // 1 tick = 1 us
+
+DigitSequencer::DigitSequencer(In14NixieTube& tube)
+    : mTube(tube), mTimer(nullptr), mCallback(nullptr), mCallbackArg(nullptr),
+      mFrames(nullptr), mCount(0), mIndex(0), mIsRunning(false),
+      mIsEnabled(false), mLatencySumUs(0), mStats{},
+      mSpinlock(portMUX_INITIALIZER_UNLOCKED) {}
+
+void DigitSequencer::initialize(DoneCallback callback, void* arg) {
+    mCallback = callback;
+    mCallbackArg = arg;
+
+    gptimer_config_t timerConfig = {};
+    timerConfig.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+    timerConfig.direction = GPTIMER_COUNT_UP;
+    timerConfig.resolution_hz = kTimerResolution;
+    ESP_ERROR_CHECK(gptimer_new_timer(&timerConfig, &mTimer));
+
+    gptimer_event_callbacks_t callbacks = {};
+    callbacks.on_alarm = onAlarm;
+    ESP_ERROR_CHECK(gptimer_register_event_callbacks(mTimer, &callbacks, this));
+}
+
+bool DigitSequencer::start(const DisplayFrame* frames, uint16_t count) {
+    if (mIsRunning || count == 0) {
+        return false;
+    }
+    mFrames = frames;
+    mCount = count;
+    mIndex = 0;
+    mIsRunning = true;
+
+    // The timer holds a power management lock while it is enabled, so it is
+    // enabled only for the sequence
+    if (!mIsEnabled) {
+        ESP_ERROR_CHECK(gptimer_enable(mTimer));
+        mIsEnabled = true;
+    }
+
+    // The first edge is an alarm too, so it is measured like the others
+    gptimer_alarm_config_t alarm = {};
+    alarm.alarm_count = kStartDelayUs;
+    ESP_ERROR_CHECK(gptimer_set_raw_count(mTimer, 0));
+    ESP_ERROR_CHECK(gptimer_set_alarm_action(mTimer, &alarm));
+    ESP_ERROR_CHECK(gptimer_start(mTimer));
+    return true;
+}
+
+void DigitSequencer::stop() {
+    portENTER_CRITICAL(&mSpinlock);
+    bool wasRunning = mIsRunning;
+    mIsRunning = false;
+    portEXIT_CRITICAL(&mSpinlock);
+    if (wasRunning) {
+        gptimer_stop(mTimer);
+    }
+    if (mIsEnabled) {
+        ESP_ERROR_CHECK(gptimer_disable(mTimer));
+        mIsEnabled = false;
+    }
+    mTube.hideDigit();
+}
+
+SequencerStats DigitSequencer::getStats() {
+    portENTER_CRITICAL(&mSpinlock);
+    SequencerStats stats = mStats;
+    if (mStats.edges > 0) {
+        stats.avgLatencyUs = mLatencySumUs / mStats.edges;
+    }
+    portEXIT_CRITICAL(&mSpinlock);
+    return stats;
+}
+
+bool DigitSequencer::onAlarm(gptimer_handle_t timer,
+                             const gptimer_alarm_event_data_t* edata,
+                             void* arg) {
+    DigitSequencer* self = static_cast<DigitSequencer*>(arg);
+    portENTER_CRITICAL_ISR(&self->mSpinlock);
+    if (!self->mIsRunning) {
+        portEXIT_CRITICAL_ISR(&self->mSpinlock);
+        return false;
+    }
+    bool isDone = self->mIndex >= self->mCount;
+    uint8_t code = isDone ? NONE : self->mFrames[self->mIndex].code;
+    self->mTube.writeCode(code);
+
+    uint64_t now = 0;
+    gptimer_get_raw_count(timer, &now);
+    uint32_t latency = now - edata->alarm_value;
+    self->mStats.edges++;
+    self->mLatencySumUs += latency;
+    if (latency > self->mStats.maxLatencyUs) {
+        self->mStats.maxLatencyUs = latency;
+    }
+
+    if (isDone) {
+        gptimer_stop(timer);
+        self->mIsRunning = false;
+        self->mStats.sequences++;
+    } else {
+        // Next edge relative to the scheduled one, not to the ISR entry
+        gptimer_alarm_config_t alarm = {};
+        alarm.alarm_count =
+            edata->alarm_value + self->mFrames[self->mIndex].durationUs;
+        gptimer_set_alarm_action(timer, &alarm);
+        self->mIndex++;
+    }
+    portEXIT_CRITICAL_ISR(&self->mSpinlock);
+
+    if (isDone && self->mCallback) {
+        return self->mCallback(self->mCallbackArg);
+    }
+    return false;
+}
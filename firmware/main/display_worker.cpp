@@ -0,0 +1,191 @@
+/******************************************************************************
+ * File:    display_worker.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Implements DisplayWorker class
+ ******************************************************************************/
+
+#include "display_worker.h"
+
+#include <algorithm>
+
+#include "esp_log.h"
+
+static const char* kTag = "display_worker";
+static constexpr uint16_t kDigitDuration = 300;
+static constexpr uint16_t kShowTimeDelay = 750;
+static constexpr uint16_t kPauseDuration = 2000;
+static constexpr uint16_t kIntroDigitPeriod = 50;
+static constexpr uint8_t kCurrentTimeRepeatTimes = 3;
+static constexpr int8_t kBlank = -1;
+
+DisplayWorker::DisplayWorker(In14NixieTube& tube, IDisplayListener& listener)
+    : mTube(tube), mListener(listener), mSequencer(tube), mIsBusy(false),
+      mJobId(0), mQueue(nullptr) {}
+
+void DisplayWorker::initialize() {
+    mSequencer.initialize(onSequenceDone, this);
+    mQueue = xQueueCreateStatic(kQueueLength, sizeof(Command), mQueueStorage,
+                                &mQueueBuffer);
+    xTaskCreateStatic(task, "displayTask", kStackSize, this, 5, mStack,
+                      &mTaskBuffer);
+}
+
+bool DisplayWorker::showTime(uint8_t hour, uint8_t minute) {
+    Command command = {};
+    command.type = CommandType::ShowTime;
+    command.hour = hour;
+    command.minute = minute;
+    return post(command);
+}
+
+bool DisplayWorker::showIntro() {
+    Command command = {};
+    command.type = CommandType::ShowIntro;
+    return post(command);
+}
+
+bool DisplayWorker::showSequence(const DisplayStep* steps, uint8_t count) {
+    if (count > kMaxDisplaySteps) {
+        return false;
+    }
+    Command command = {};
+    command.type = CommandType::ShowSequence;
+    command.stepCount = count;
+    std::copy(steps, steps + count, command.steps);
+    return post(command);
+}
+
+bool DisplayWorker::cancel() {
+    Command command = {};
+    command.type = CommandType::Cancel;
+    return post(command);
+}
+
+bool DisplayWorker::isBusy() const { return mIsBusy; }
+
+SequencerStats DisplayWorker::getSequencerStats() {
+    return mSequencer.getStats();
+}
+
+void DisplayWorker::task(void* param) {
+    DisplayWorker* self = static_cast<DisplayWorker*>(param);
+    while (true) {
+        if (xQueueReceive(self->mQueue, &self->mCommand, portMAX_DELAY) ==
+            pdTRUE) {
+            self->execute(self->mCommand);
+        }
+    }
+}
+
+bool DisplayWorker::onSequenceDone(void* param) {
+    DisplayWorker* self = static_cast<DisplayWorker*>(param);
+    BaseType_t isHigherPriorityTaskWoken = pdFALSE;
+    xQueueSendToFrontFromISR(self->mQueue, &self->mDoneCommand,
+                             &isHigherPriorityTaskWoken);
+    return isHigherPriorityTaskWoken == pdTRUE;
+}
+
+bool DisplayWorker::post(const Command& command) {
+    // one slot is always kept free for the end of sequence event
+    if (!mQueue || uxQueueSpacesAvailable(mQueue) < 2) {
+        return false;
+    }
+    return xQueueSend(mQueue, &command, 0) == pdTRUE;
+}
+
+void DisplayWorker::execute(const Command& command) {
+    DisplayStep steps[kMaxDisplaySteps];
+    switch (command.type) {
+    case CommandType::ShowTime: {
+        uint8_t count = composeIntro(steps);
+        count += composeTime(steps + count, command.hour, command.minute);
+        play(steps, count);
+        break;
+    }
+    case CommandType::ShowIntro:
+        play(steps, composeIntro(steps));
+        break;
+    case CommandType::ShowSequence:
+        // copy the steps, the command buffer is reused while playing
+        std::copy(command.steps, command.steps + command.stepCount, steps);
+        play(steps, command.stepCount);
+        break;
+    case CommandType::SequenceDone:
+        break;   // end of an interrupted sequence, nothing to do
+    case CommandType::Cancel:
+    default:
+        mTube.hideDigit();
+        break;
+    }
+}
+
+uint8_t DisplayWorker::composeIntro(DisplayStep* steps) {
+    // A fast countdown of digits from 9 to 0 shown as an intro before the
+    // actual time
+    uint8_t count = 0;
+    for (int8_t i = 9; i >= 0; --i) {
+        steps[count++] = {i, kIntroDigitPeriod};
+    }
+    steps[count++] = {kBlank, kShowTimeDelay};
+    return count;
+}
+
+uint8_t DisplayWorker::composeTime(DisplayStep* steps, uint8_t hour,
+                                   uint8_t minute) {
+    // Since there is only one nixie tube it is needed to sequentially show
+    // digits. The time is displayed in the following format:
+    // H <pause> H <pause> M <pause> M
+    const int8_t digits[] = {static_cast<int8_t>(hour / 10),
+                             static_cast<int8_t>(hour % 10),
+                             static_cast<int8_t>(minute / 10),
+                             static_cast<int8_t>(minute % 10)};
+    uint8_t count = 0;
+    for (auto i = 0; i < kCurrentTimeRepeatTimes; ++i) {
+        for (auto digit : digits) {
+            steps[count++] = {digit, kDigitDuration};
+            steps[count++] = {kBlank, kDigitDuration};
+        }
+        if (i < kCurrentTimeRepeatTimes - 1) {
+            steps[count++] = {kBlank, kPauseDuration};
+        }
+    }
+    return count;
+}
+
+void DisplayWorker::play(const DisplayStep* steps, uint8_t count) {
+    if (count == 0) {
+        return;
+    }
+    for (uint8_t i = 0; i < count; ++i) {
+        mFrames[i].code =
+            steps[i].digit < 0 ? NONE : In14NixieTube::toCode(steps[i].digit);
+        mFrames[i].durationUs = steps[i].durationMs * 1000u;
+    }
+    mDoneCommand.type = CommandType::SequenceDone;
+    mDoneCommand.jobId = ++mJobId;
+
+    mIsBusy = true;
+    mListener.onDisplayStarted();
+    mSequencer.start(mFrames, count);
+    // Wait for the end of the sequence or for a new request, which
+    // interrupts the sequence and stays in the queue
+    while (xQueuePeek(mQueue, &mCommand, portMAX_DELAY) == pdTRUE) {
+        if (mCommand.type != CommandType::SequenceDone) {
+            break;
+        }
+        xQueueReceive(mQueue, &mCommand, 0);
+        if (mCommand.jobId == mJobId) {
+            break;
+        }
+    }
+    mSequencer.stop();
+    mListener.onDisplayFinished();
+    mIsBusy = false;
+
+    SequencerStats stats = mSequencer.getStats();
+    ESP_LOGI(kTag,
+             "Sequencer edges: %" PRIu32 ", max latency: %" PRIu32
+             " us, avg latency: %" PRIu32 " us",
+             stats.edges, stats.maxLatencyUs, stats.avgLatencyUs);
+}
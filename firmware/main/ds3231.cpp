@@ -7,47 +7,260 @@
 
 #include "ds3231.h"
 
+#include <algorithm>
+#include <mutex>
+
+#include "civil_time.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+
 static constexpr uint8_t kAddr = 0x68;
 static constexpr u_int32_t kFreq = 400000;   // Hz
 static constexpr uint8_t kTimeReg = 0x00;
+static constexpr uint8_t kTimeRegCount = 7;
+static constexpr uint8_t kAlarm2Reg = 0x0B;
+static constexpr uint8_t kAlarm2RegCount = 3;
+static constexpr uint8_t kAlarmMask = 0x80;      // A2Mx, ignore the field
+static constexpr uint8_t kControlReg = 0x0E;
+static constexpr uint8_t kControlA1ie = 0x01;    // alarm 1 interrupt enable
+static constexpr uint8_t kControlA2ie = 0x02;    // alarm 2 interrupt enable
+static constexpr uint8_t kControlIntcn = 0x04;   // INT instead of SQW output
+static constexpr uint8_t kControlRs1 = 0x08;     // SQW rate select
+static constexpr uint8_t kControlRs2 = 0x10;
+static constexpr uint8_t kControlConv = 0x20;    // start temperature conversion
+static constexpr uint8_t kStatusReg = 0x0F;
+static constexpr uint8_t kStatusA2f = 0x02;      // alarm 2 flag
+static constexpr uint8_t kStatusOsf = 0x80;      // oscillator stop flag
+static constexpr uint8_t kAgingReg = 0x10;
+static constexpr uint8_t kTemperatureReg = 0x11;
+static constexpr uint8_t kTemperatureRegCount = 2;
 
-Ds3231::Ds3231(I2cBus& bus) : mBus(bus) {}
+Ds3231::Ds3231(I2cBus& bus)
+    : mBus(bus), mDevHandle(nullptr), mRegisters{}, mIntPin(GPIO_NUM_NC),
+      mAlarmCallback(nullptr), mAlarmArg(nullptr), mLastEdgeUs(0),
+      mSpinlock(portMUX_INITIALIZER_UNLOCKED) {}
 
 void Ds3231::initialize() {
     ESP_ERROR_CHECK(mBus.addDevice(kAddr, kFreq, &mDevHandle));
+    refresh();
+}
+
+bool Ds3231::refresh(uint8_t first, uint8_t count) {
+    if (first + count > kRegisterCount) {
+        return false;
+    }
+    std::lock_guard<Mutex> lock(mMutex);
+    return mBus.read(mDevHandle, &first, 1, &mRegisters[first], count) ==
+           ESP_OK;
+}
+
+uint8_t Ds3231::getRegister(uint8_t reg) {
+    std::lock_guard<Mutex> lock(mMutex);
+    return reg < kRegisterCount ? mRegisters[reg] : 0;
+}
+
+bool Ds3231::updateRegister(uint8_t reg, uint8_t mask, uint8_t value) {
+    if (reg >= kRegisterCount) {
+        return false;
+    }
+    std::lock_guard<Mutex> lock(mMutex);
+    uint8_t updated = (mRegisters[reg] & ~mask) | (value & mask);
+    if (updated == mRegisters[reg]) {
+        return true;
+    }
+    if (!writeRegisters(reg, &updated, 1)) {
+        return false;
+    }
+    mRegisters[reg] = updated;
+    return true;
+}
+
+bool Ds3231::hasOscillatorStopped() {
+    return getRegister(kStatusReg) & kStatusOsf;
+}
+
+bool Ds3231::sampleTemperature() {
+    if (!refresh(kTemperatureReg, kTemperatureRegCount)) {
+        return false;
+    }
+    int16_t quarterDegrees;
+    {
+        std::lock_guard<Mutex> lock(mMutex);
+        // Two's complement integer part, fraction in the upper two bits
+        quarterDegrees = static_cast<int8_t>(mRegisters[kTemperatureReg]) * 4 +
+                         (mRegisters[kTemperatureReg + 1] >> 6);
+    }
+    mTemperatureHistory.add(quarterDegrees);
+    return true;
+}
+
+TemperatureStats Ds3231::getTemperatureStats(size_t points) const {
+    return mTemperatureHistory.getStats(points, kTemperatureInterval);
 }
 
 bool Ds3231::getTime(struct tm* tm) {
-    uint8_t reg = kTimeReg;
-    uint8_t buf[7];
-    if (mBus.read(mDevHandle, &reg, 1, buf, sizeof(buf)) != ESP_OK) {
+    if (!refresh(kTimeReg, kTimeRegCount)) {
         return false;
     }
-    tm->tm_sec = bcd2dec(buf[0]);
-    tm->tm_min = bcd2dec(buf[1]);
-    tm->tm_hour = bcd2dec(buf[2]);
-    tm->tm_mday = bcd2dec(buf[4]);
-    tm->tm_mon = bcd2dec(buf[5]) - 1;
-    tm->tm_year = bcd2dec(buf[6]) + 100;
+    std::lock_guard<Mutex> lock(mMutex);
+    const uint8_t* buf = &mRegisters[kTimeReg];
+    tm->tm_sec = bcdToDec(buf[0]);
+    tm->tm_min = bcdToDec(buf[1]);
+    tm->tm_hour = bcdToDec(buf[2] & 0x3F);   // always written in 24 h mode
+    tm->tm_mday = bcdToDec(buf[4]);
+    tm->tm_mon = bcdToDec(buf[5] & 0x1F) - 1;
+    tm->tm_year = bcdToDec(buf[6]) + 100;
+    tm->tm_wday = weekdayFromDays(
+        daysFromCivil(tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday));
     return true;
 }
 
 bool Ds3231::setTime(const struct tm* tm) {
-    uint8_t buf[8];
-    buf[0] = kTimeReg;   // register address
-    buf[1] = dec2bcd(tm->tm_sec);
-    buf[2] = dec2bcd(tm->tm_min);
-    buf[3] = dec2bcd(tm->tm_hour);
-    buf[4] = 0;   // weekday (not used)
-    buf[5] = dec2bcd(tm->tm_mday);
-    buf[6] = dec2bcd(tm->tm_mon + 1);
-    buf[7] = dec2bcd(tm->tm_year - 100);
-    if (mBus.write(mDevHandle, buf, sizeof(buf)) != ESP_OK) {
+    uint8_t buf[kTimeRegCount];
+    buf[0] = decToBcd(tm->tm_sec);
+    buf[1] = decToBcd(tm->tm_min);
+    buf[2] = decToBcd(tm->tm_hour);
+    uint32_t weekday = weekdayFromDays(
+        daysFromCivil(tm->tm_year + 1900, tm->tm_mon + 1, tm->tm_mday));
+    buf[3] = weekday == 0 ? 7 : weekday;   // 1-7, Sunday is 7
+    buf[4] = decToBcd(tm->tm_mday);
+    buf[5] = decToBcd(tm->tm_mon + 1);
+    buf[6] = decToBcd(tm->tm_year - 100);
+    {
+        std::lock_guard<Mutex> lock(mMutex);
+        if (!writeRegisters(kTimeReg, buf, sizeof(buf))) {
+            return false;
+        }
+        std::copy(buf, buf + sizeof(buf), &mRegisters[kTimeReg]);
+    }
+    // The time is valid again
+    return updateRegister(kStatusReg, kStatusOsf, 0);
+}
+
+esp_err_t Ds3231::enableSquareWave(gpio_num_t sqwPin) {
+    // SQW output with RS2 = RS1 = 0 selects 1 Hz
+    if (!updateRegister(kControlReg, kControlIntcn | kControlRs1 | kControlRs2,
+                        0)) {
+        return ESP_FAIL;
+    }
+
+    // SQW is an open-drain output
+    gpio_config_t ioConfig = {};
+    ioConfig.pin_bit_mask = 1ULL << sqwPin;
+    ioConfig.mode = GPIO_MODE_INPUT;
+    ioConfig.pull_up_en = GPIO_PULLUP_ENABLE;
+    ioConfig.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    ioConfig.intr_type = GPIO_INTR_NEGEDGE;
+    esp_err_t err = gpio_config(&ioConfig);
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {   // already installed
+        return err;
+    }
+    return gpio_isr_handler_add(sqwPin, onSquareWaveEdge, this);
+}
+
+esp_err_t Ds3231::enableMinuteAlarm(gpio_num_t intPin, AlarmCallback callback,
+                                    void* arg) {
+    mIntPin = intPin;
+    mAlarmCallback = callback;
+    mAlarmArg = arg;
+
+    // A2M2 = A2M3 = A2M4 = 1 matches once per minute, at 00 seconds
+    uint8_t alarm[kAlarm2RegCount] = {kAlarmMask, kAlarmMask, kAlarmMask};
+    {
+        std::lock_guard<Mutex> lock(mMutex);
+        if (!writeRegisters(kAlarm2Reg, alarm, sizeof(alarm))) {
+            return ESP_FAIL;
+        }
+        std::copy(alarm, alarm + sizeof(alarm), &mRegisters[kAlarm2Reg]);
+    }
+    if (!updateRegister(kControlReg,
+                        kControlIntcn | kControlA1ie | kControlA2ie,
+                        kControlIntcn | kControlA2ie) ||
+        !refresh(kStatusReg, 1) || !updateRegister(kStatusReg, kStatusA2f, 0)) {
+        return ESP_FAIL;
+    }
+
+    // INT is an open-drain output held low until the flag is cleared, light
+    // sleep is woken up by the level
+    gpio_config_t ioConfig = {};
+    ioConfig.pin_bit_mask = 1ULL << intPin;
+    ioConfig.mode = GPIO_MODE_INPUT;
+    ioConfig.pull_up_en = GPIO_PULLUP_ENABLE;
+    ioConfig.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    ioConfig.intr_type = GPIO_INTR_LOW_LEVEL;
+    esp_err_t err = gpio_config(&ioConfig);
+    if (err == ESP_OK) {
+        err = gpio_wakeup_enable(intPin, GPIO_INTR_LOW_LEVEL);
+    }
+    if (err == ESP_OK) {
+        err = esp_sleep_enable_gpio_wakeup();
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    err = gpio_install_isr_service(0);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {   // already installed
+        return err;
+    }
+    return gpio_isr_handler_add(intPin, onAlarmEdge, this);
+}
+
+bool Ds3231::acknowledgeAlarm() {
+    // The flag is set by the RTC, the mirror has to be refreshed first
+    if (!refresh(kStatusReg, 1) || !updateRegister(kStatusReg, kStatusA2f, 0)) {
         return false;
     }
+    gpio_intr_enable(mIntPin);
     return true;
 }
 
-uint8_t Ds3231::bcd2dec(uint8_t val) { return (val >> 4) * 10 + (val & 0x0F); }
+bool Ds3231::setAgingOffset(int8_t offset) {
+    if (!updateRegister(kAgingReg, 0xFF, static_cast<uint8_t>(offset))) {
+        return false;
+    }
+    // CONV is cleared by the RTC when the conversion is done, so it is not
+    // kept in the mirror
+    std::lock_guard<Mutex> lock(mMutex);
+    uint8_t control = mRegisters[kControlReg] | kControlConv;
+    return writeRegisters(kControlReg, &control, 1);
+}
+
+int64_t Ds3231::getLastEdgeUs() {
+    portENTER_CRITICAL(&mSpinlock);
+    int64_t edgeUs = mLastEdgeUs;
+    portEXIT_CRITICAL(&mSpinlock);
+    return edgeUs;
+}
+
+void Ds3231::onSquareWaveEdge(void* arg) {
+    Ds3231* self = static_cast<Ds3231*>(arg);
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL_ISR(&self->mSpinlock);
+    self->mLastEdgeUs = now;
+    portEXIT_CRITICAL_ISR(&self->mSpinlock);
+}
 
-uint8_t Ds3231::dec2bcd(uint8_t val) { return ((val / 10) << 4) | (val % 10); }
\ No newline at end of file
+void Ds3231::onAlarmEdge(void* arg) {
+    Ds3231* self = static_cast<Ds3231*>(arg);
+    int64_t now = esp_timer_get_time();
+    // The level stays low until the alarm is acknowledged
+    gpio_intr_disable(self->mIntPin);
+    portENTER_CRITICAL_ISR(&self->mSpinlock);
+    self->mLastEdgeUs = now;
+    portEXIT_CRITICAL_ISR(&self->mSpinlock);
+    if (self->mAlarmCallback) {
+        self->mAlarmCallback(self->mAlarmArg);
+    }
+}
+
+bool Ds3231::writeRegisters(uint8_t first, const uint8_t* values,
+                            uint8_t count) {
+    uint8_t buf[kRegisterCount + 1];
+    buf[0] = first;   // register address
+    std::copy(values, values + count, &buf[1]);
+    return mBus.write(mDevHandle, buf, count + 1) == ESP_OK;
+}
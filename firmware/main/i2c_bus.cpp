@@ -46,12 +46,11 @@ esp_err_t I2cBus::write(i2c_master_dev_handle_t dev, const uint8_t* data,
 esp_err_t I2cBus::read(i2c_master_dev_handle_t dev, const uint8_t* reg,
                        size_t reg_len, uint8_t* data, size_t data_len,
                        uint32_t timeout_ms) {
-    // If reg_len == 0, just read
+    // If reg_len == 0, just read, otherwise write the register address and
+    // read back with a repeated start in a single transaction
     if (reg_len > 0) {
-        esp_err_t ret =
-            i2c_master_transmit(dev, reg, reg_len, pdMS_TO_TICKS(timeout_ms));
-        if (ret != ESP_OK)
-            return ret;
+        return i2c_master_transmit_receive(dev, reg, reg_len, data, data_len,
+                                           pdMS_TO_TICKS(timeout_ms));
     }
     return i2c_master_receive(dev, data, data_len, pdMS_TO_TICKS(timeout_ms));
 }
\ No newline at end of file
@@ -18,10 +18,19 @@ void In14NixieTube::showDigit(uint8_t digit) {
     if (digit > 9) {
         return;
     }
+    mDecoder.decode(toCode(digit));
+}
+
+void In14NixieTube::hideDigit() { mDecoder.decode(NONE); }
+
+uint8_t In14NixieTube::toCode(uint8_t digit) {
+    if (digit > 9) {
+        return NONE;
+    }
     // The part that I used in EAGLE when creating my PCB layout was incorrect
     // (at least for my tubes). My tubes seem to have a different pinout.
-    const uint8_t truthTable[] = {1, 0, 9, 8, 7, 6, 5, 4, 3, 2};
-    mDecoder.decode(truthTable[digit]);
+    static const uint8_t truthTable[] = {1, 0, 9, 8, 7, 6, 5, 4, 3, 2};
+    return truthTable[digit];
 }
 
-void In14NixieTube::hideDigit() { mDecoder.decode(NONE); }
\ No newline at end of file
+void In14NixieTube::writeCode(uint8_t code) { mDecoder.decode(code); }
\ No newline at end of file
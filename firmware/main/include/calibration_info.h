@@ -0,0 +1,92 @@
+/******************************************************************************
+ * File:    calibration_info.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Declaration of a data class used for RTC calibration state
+ ******************************************************************************/
+
+#ifndef calibration_info_h
+#define calibration_info_h
+
+#include <inttypes.h>
+
+/**
+ * @brief Represents a data class used for storing the RTC calibration
+ */
+class CalibrationInfo {
+  public:
+    /**
+     * @brief Default constructor
+     */
+    CalibrationInfo() = default;
+
+    /**
+     * @brief Construct a new Calibration Info object
+     *
+     * @param agingOffset value of the DS3231 aging offset register
+     * @param driftPpb last measured drift of the RTC in ppb
+     * @param syncInterval NTP sync interval in milliseconds
+     */
+    CalibrationInfo(int8_t agingOffset, int32_t driftPpb,
+                    uint32_t syncInterval);
+
+    /**
+     * @brief Default destructor
+     */
+    ~CalibrationInfo() = default;
+
+    /**
+     * @brief Default copy constructor
+     * @param calibrationInfo CalibrationInfo object
+     */
+    CalibrationInfo(const CalibrationInfo& calibrationInfo) = default;
+
+    /**
+     * @brief Getter for aging offset
+     *
+     * @return int8_t value
+     */
+    int8_t getAgingOffset() const;
+
+    /**
+     * @brief Setter for aging offset
+     *
+     * @param value value
+     */
+    void setAgingOffset(const int8_t value);
+
+    /**
+     * @brief Getter for drift
+     *
+     * @return int32_t value in ppb, positive if the RTC runs fast
+     */
+    int32_t getDriftPpb() const;
+
+    /**
+     * @brief Setter for drift
+     *
+     * @param value value in ppb
+     */
+    void setDriftPpb(const int32_t value);
+
+    /**
+     * @brief Getter for sync interval
+     *
+     * @return uint32_t value in milliseconds
+     */
+    uint32_t getSyncInterval() const;
+
+    /**
+     * @brief Setter for sync interval
+     *
+     * @param value value in milliseconds
+     */
+    void setSyncInterval(const uint32_t value);
+
+  private:
+    int8_t mAgingOffset = 0;
+    int32_t mDriftPpb = 0;
+    uint32_t mSyncInterval = 3600000;   // 1 hour
+};
+
+#endif   // calibration_info_h
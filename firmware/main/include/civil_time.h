@@ -0,0 +1,153 @@
+/******************************************************************************
+ * File:    civil_time.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Constexpr civil date arithmetic and BCD helpers
+ ******************************************************************************/
+
+#ifndef civil_time_h
+#define civil_time_h
+
+#include <ctime>
+#include <inttypes.h>
+
+/**
+ * @brief Date in the proleptic Gregorian calendar
+ */
+struct CivilDate {
+    int32_t year;    ///< e.g. 2025
+    uint32_t month;  ///< 1-12
+    uint32_t day;    ///< 1-31
+};
+
+/**
+ * @brief Get the number of days since 1970-01-01
+ *
+ * Based on the days_from_civil algorithm by Howard Hinnant. The year is
+ * shifted to start in March, so the leap day is the last day of the year.
+ *
+ * @param year year
+ * @param month month 1-12
+ * @param day day of the month 1-31
+ * @return days since the epoch, negative before it
+ */
+constexpr int32_t daysFromCivil(int32_t year, uint32_t month, uint32_t day) {
+    year -= month <= 2;
+    const int32_t era = (year >= 0 ? year : year - 399) / 400;
+    const uint32_t yearOfEra = static_cast<uint32_t>(year - era * 400);
+    const uint32_t dayOfYear =
+        (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const uint32_t dayOfEra =
+        yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + static_cast<int32_t>(dayOfEra) - 719468;
+}
+
+/**
+ * @brief Get the date of a day since 1970-01-01
+ *
+ * Inverse of daysFromCivil().
+ *
+ * @param days days since the epoch
+ * @return civil date
+ */
+constexpr CivilDate civilFromDays(int32_t days) {
+    days += 719468;
+    const int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const uint32_t dayOfEra = static_cast<uint32_t>(days - era * 146097);
+    const uint32_t yearOfEra =
+        (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) /
+        365;
+    const uint32_t dayOfYear =
+        dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const uint32_t shiftedMonth = (5 * dayOfYear + 2) / 153;   // March = 0
+    const uint32_t day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+    const uint32_t month = shiftedMonth < 10 ? shiftedMonth + 3
+                                             : shiftedMonth - 9;
+    const int32_t year = static_cast<int32_t>(yearOfEra) + era * 400;
+    return {year + (month <= 2), month, day};
+}
+
+/**
+ * @brief Get the day of the week of a day since 1970-01-01
+ *
+ * @param days days since the epoch
+ * @return 0-6, Sunday is 0 (as tm_wday)
+ */
+constexpr uint32_t weekdayFromDays(int32_t days) {
+    // 1970-01-01 was a Thursday
+    return static_cast<uint32_t>(days >= -4 ? (days + 4) % 7
+                                            : (days + 5) % 7 + 6);
+}
+
+/**
+ * @brief Convert a broken down UTC time to seconds since the epoch
+ *
+ * Unlike mktime() the time zone is not used, the fields are not normalized
+ * and tm is not modified. tm_wday, tm_yday and tm_isdst are ignored.
+ *
+ * @param tm broken down UTC time with fields in their ranges
+ * @return seconds since the epoch
+ */
+constexpr time_t timegmUtc(const struct tm& tm) {
+    const int64_t days = daysFromCivil(tm.tm_year + 1900, tm.tm_mon + 1,
+                                       tm.tm_mday);
+    return static_cast<time_t>(days * 86400 + tm.tm_hour * 3600 +
+                               tm.tm_min * 60 + tm.tm_sec);
+}
+
+/**
+ * @brief Convert seconds since the epoch to a broken down UTC time
+ *
+ * Thread safe replacement of gmtime_r(). tm_isdst is set to 0.
+ *
+ * @param time seconds since the epoch
+ * @param[out] tm broken down UTC time
+ */
+inline void gmtimeUtc(time_t time, struct tm* tm) {
+    int64_t days = time / 86400;
+    int64_t seconds = time % 86400;
+    if (seconds < 0) {
+        seconds += 86400;
+        days--;
+    }
+    const CivilDate date = civilFromDays(static_cast<int32_t>(days));
+    tm->tm_year = date.year - 1900;
+    tm->tm_mon = date.month - 1;
+    tm->tm_mday = date.day;
+    tm->tm_hour = seconds / 3600;
+    tm->tm_min = seconds / 60 % 60;
+    tm->tm_sec = seconds % 60;
+    tm->tm_wday = weekdayFromDays(days);
+    tm->tm_yday = days - daysFromCivil(date.year, 1, 1);
+    tm->tm_isdst = 0;
+}
+
+/**
+ * @brief Convert a packed BCD byte to binary
+ */
+constexpr uint8_t bcdToDec(uint8_t value) {
+    return (value >> 4) * 10 + (value & 0x0F);
+}
+
+/**
+ * @brief Convert a binary value 0-99 to a packed BCD byte
+ */
+constexpr uint8_t decToBcd(uint8_t value) {
+    return ((value / 10) << 4) | (value % 10);
+}
+
+// Compile time checks of the conversions
+static_assert(daysFromCivil(1970, 1, 1) == 0, "epoch");
+static_assert(daysFromCivil(2000, 3, 1) == 11017, "leap day of 2000");
+static_assert(daysFromCivil(1969, 12, 31) == -1, "day before the epoch");
+static_assert(civilFromDays(11016).month == 2 &&
+                  civilFromDays(11016).day == 29,
+              "2000-02-29");
+static_assert(civilFromDays(daysFromCivil(2100, 3, 1)).day == 1,
+              "2100 is not a leap year");
+static_assert(weekdayFromDays(0) == 4 && weekdayFromDays(-1) == 3 &&
+                  weekdayFromDays(-5) == 6,
+              "weekday");
+static_assert(bcdToDec(0x59) == 59 && decToBcd(59) == 0x59, "BCD");
+
+#endif   // civil_time_h
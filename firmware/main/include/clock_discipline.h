@@ -0,0 +1,95 @@
+/******************************************************************************
+ * File:    clock_discipline.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Declaration of a service aligning the system clock to the RTC
+ ******************************************************************************/
+
+#ifndef clock_discipline_h
+#define clock_discipline_h
+
+#include <inttypes.h>
+
+#include "driver/gpio.h"
+
+#include "ds3231.h"
+#include "mutex.h"
+#include "rtc_calibrator.h"
+
+/**
+ * @brief Keeps the sub-second phase of the system clock aligned to the RTC
+ *
+ * The DS3231 1 Hz square wave marks the RTC second boundaries. Once per
+ * second the system time at the last edge is compared with the RTC time and
+ * the difference is slewed out with adjtime(), or stepped if it is large.
+ * The first comparison reads the RTC seconds register to resolve the whole
+ * seconds, the following ones only correct the phase.
+ *
+ * When NTP synchronizes the system time, the RTC offset against the
+ * synchronized time is handed to the RtcCalibrator right away. NTP owns the
+ * clock until its offset is slewed out, then the RTC is rewritten if the
+ * calibrator asked for it. The discipline resumes afterwards and keeps the
+ * system clock at that offset from the RTC, so between the NTP polls (or
+ * without NTP at all) the time runs at the calibrated RTC rate instead of
+ * the ESP32 crystal.
+ *
+ * In the low power mode the square wave is replaced by the minute alarm of
+ * the RTC, whose edges are full seconds as well. update() is then called
+ * once per alarm instead of once per second.
+ */
+class ClockDiscipline {
+  public:
+    /**
+     * @brief Construct a new Clock Discipline object
+     *
+     * @param rtc initialized RTC driver
+     * @param calibrator RTC calibrator fed after every NTP sync
+     */
+    ClockDiscipline(Ds3231& rtc, RtcCalibrator& calibrator);
+
+    /**
+     * @brief Enable the square-wave output of the RTC
+     *
+     * @param sqwPin GPIO connected to the SQW/INT pin of the RTC
+     */
+    void initialize(gpio_num_t sqwPin);
+
+    /**
+     * @brief Run one discipline step
+     *
+     * Must be called once per second shortly after the system second
+     * boundary (or right after the minute alarm), from a single task.
+     *
+     * @return True if the system clock was stepped
+     */
+    bool update();
+
+    /**
+     * @brief Notify that the system time was synchronized by NTP
+     *
+     * Must be called right after the NTP offset was applied, the RTC
+     * calibrator has the new sample when it returns (except in the low power
+     * mode). Can be called from any task.
+     */
+    void onNtpSync();
+
+  private:
+    bool measureOffset(int64_t edgeUs, bool resolveSeconds, int64_t* offsetUs);
+    bool handleNtpSync();
+    void addSample(int64_t offsetUs);
+    static int64_t getRemainingSlewUs();
+    bool writeRtc();
+
+    Ds3231& mRtc;
+    RtcCalibrator& mCalibrator;
+    int64_t mLastEdgeUs;
+    int64_t mRtcOffsetUs;   // RTC minus NTP time at the last sync
+    bool mIsLocked;
+    bool mIsNtpSyncPending;
+    bool mIsSamplePending;
+    bool mIsRtcWritePending;
+    bool mIsReferencePending;
+    Mutex mMutex;
+};
+
+#endif   // clock_discipline_h
@@ -11,8 +11,12 @@
 #include <inttypes.h>
 #include <optional>
 
+#include "config_store_stats.h"
+#include "device_config.h"
 #include "led_info.h"
 #include "sleep_info.h"
+#include "sync_status.h"
+#include "temperature_history.h"
 #include "time_info.h"
 #include "wifi_info.h"
 
@@ -79,6 +83,42 @@ class IClock {
      * @param timeInfo time info
      */
     virtual void onSetTimeInfo(const TimeInfo& timeInfo) = 0;
+
+    /**
+     * @brief Return all config sections
+     *
+     * @return DeviceConfig object, sections which are not stored are empty
+     */
+    virtual DeviceConfig onGetConfig() const = 0;
+
+    /**
+     * @brief Set several config sections and save them in a single commit
+     *
+     * @param config sections to set, missing ones are left unchanged
+     */
+    virtual void onSetConfig(const DeviceConfig& config) = 0;
+
+    /**
+     * @brief Return status of the time synchronization
+     *
+     * @return SyncStatus object
+     */
+    virtual SyncStatus onGetSyncStatus() const = 0;
+
+    /**
+     * @brief Return statistics of the RTC temperature
+     *
+     * @param points maximum number of points of the downsampled series
+     * @return TemperatureStats object
+     */
+    virtual TemperatureStats onGetTemperatureStats(size_t points) const = 0;
+
+    /**
+     * @brief Return the write counters of the config store
+     *
+     * @return ConfigStoreStats object
+     */
+    virtual ConfigStoreStats onGetConfigStoreStats() const = 0;
 };
 
 #endif   // clock_iface_h
\ No newline at end of file
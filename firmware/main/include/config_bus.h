@@ -0,0 +1,115 @@
+/******************************************************************************
+ * File:    config_bus.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Typed publish/subscribe bus for config changes
+ ******************************************************************************/
+
+#ifndef config_bus_h
+#define config_bus_h
+
+#include <mutex>
+#include <stddef.h>
+
+#include "mutex.h"
+
+/**
+ * @brief List of subscribers to the changes of one config type
+ *
+ * @note
+ * - Callbacks are invoked in the task of the publisher, without any lock
+ *   held, and should only hand the value over.
+ */
+template <typename T> class ConfigTopic {
+  public:
+    /// @brief Called with the new value after it is stored
+    using Callback = void (*)(const T& value, void* param);
+
+    /// @brief Maximum number of subscribers of a topic
+    static constexpr size_t kMaxSubscribers = 4;
+
+    /**
+     * @brief Add a subscriber
+     *
+     * @param callback function called on every change
+     * @param param argument passed to the callback
+     * @return False if the topic has no free subscriber slot
+     */
+    bool subscribe(Callback callback, void* param) {
+        std::lock_guard<Mutex> lock(mMutex);
+        if (mCount == kMaxSubscribers) {
+            return false;
+        }
+        mSubscribers[mCount++] = {callback, param};
+        return true;
+    }
+
+    /**
+     * @brief Notify all subscribers about a new value
+     *
+     * @param value new value
+     */
+    void publish(const T& value) {
+        Subscriber subscribers[kMaxSubscribers];
+        size_t count;
+        {
+            std::lock_guard<Mutex> lock(mMutex);
+            count = mCount;
+            for (size_t i = 0; i < count; ++i) {
+                subscribers[i] = mSubscribers[i];
+            }
+        }
+        for (size_t i = 0; i < count; ++i) {
+            subscribers[i].callback(value, subscribers[i].param);
+        }
+    }
+
+  private:
+    struct Subscriber {
+        Callback callback;
+        void* param;
+    };
+
+    Mutex mMutex;
+    Subscriber mSubscribers[kMaxSubscribers] = {};
+    size_t mCount = 0;
+};
+
+/**
+ * @brief Routes config changes from the config store to the components
+ *
+ * There is one topic per config type, so a subscriber receives the changed
+ * value itself and never has to read it back from the config store.
+ */
+class ConfigBus {
+  public:
+    /**
+     * @brief Subscribe to the changes of a config type
+     *
+     * @param callback function called on every change
+     * @param param argument passed to the callback
+     * @return False if the topic has no free subscriber slot
+     */
+    template <typename T>
+    static bool subscribe(typename ConfigTopic<T>::Callback callback,
+                          void* param) {
+        return topic<T>().subscribe(callback, param);
+    }
+
+    /**
+     * @brief Publish a changed config value
+     *
+     * @param value new value
+     */
+    template <typename T> static void publish(const T& value) {
+        topic<T>().publish(value);
+    }
+
+  private:
+    template <typename T> static ConfigTopic<T>& topic() {
+        static ConfigTopic<T> sTopic;
+        return sTopic;
+    }
+};
+
+#endif   // config_bus_h
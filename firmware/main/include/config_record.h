@@ -0,0 +1,183 @@
+/******************************************************************************
+ * File:    config_record.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Declarations for the binary config record encoding
+ ******************************************************************************/
+
+#ifndef config_record_h
+#define config_record_h
+
+#include <inttypes.h>
+#include <stddef.h>
+
+/**
+ * @brief Header in front of the payload of a binary config record
+ */
+struct RecordHeader {
+    uint32_t magic;     ///< kRecordMagic
+    uint16_t version;   ///< layout version of the payload
+    uint16_t length;    ///< payload length in bytes
+    uint32_t crc;       ///< CRC-32 of the payload
+};
+
+static_assert(sizeof(RecordHeader) == 12, "RecordHeader must not be padded");
+
+/// @brief Magic number of a config record, "NXCF" in file order
+static constexpr uint32_t kRecordMagic = 0x4643584E;
+
+/**
+ * @brief Serializes values into a record payload
+ *
+ * Integers are stored little endian, strings and byte blocks are prefixed
+ * with a 16-bit length. The payload is written into a buffer of the caller,
+ * writes past its end are dropped and mark the writer invalid.
+ */
+class RecordWriter {
+  public:
+    /**
+     * @brief Construct a new RecordWriter
+     *
+     * @param data payload buffer
+     * @param capacity buffer size in bytes
+     */
+    RecordWriter(uint8_t* data, size_t capacity);
+
+    /**
+     * @brief Append an 8-bit value
+     *
+     * @param value value
+     */
+    void putU8(uint8_t value);
+
+    /**
+     * @brief Append a 16-bit value
+     *
+     * @param value value
+     */
+    void putU16(uint16_t value);
+
+    /**
+     * @brief Append a 32-bit value
+     *
+     * @param value value
+     */
+    void putU32(uint32_t value);
+
+    /**
+     * @brief Append a string
+     *
+     * @param value terminated string, at most 65535 characters
+     */
+    void putString(const char* value);
+
+    /**
+     * @brief Append a byte block
+     *
+     * @param data bytes
+     * @param size number of bytes, at most 65535
+     */
+    void putBytes(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Get the number of bytes written
+     *
+     * @return payload length
+     */
+    size_t getSize() const;
+
+    /**
+     * @brief Check if all values fit the buffer
+     *
+     * @return True if the payload is complete
+     */
+    bool isValid() const;
+
+  private:
+    uint8_t* take(size_t size);
+
+    uint8_t* mData;
+    size_t mCapacity;
+    size_t mSize;
+    bool mIsOverrun;
+};
+
+/**
+ * @brief Deserializes values from a record payload
+ *
+ * Reads past the end of the payload return zero values and mark the reader
+ * invalid, so a record can be decoded first and checked once at the end.
+ */
+class RecordReader {
+  public:
+    /**
+     * @brief Construct a new RecordReader
+     *
+     * @param data payload
+     * @param size payload length in bytes
+     */
+    RecordReader(const uint8_t* data, size_t size);
+
+    /**
+     * @brief Read an 8-bit value
+     *
+     * @return value
+     */
+    uint8_t getU8();
+
+    /**
+     * @brief Read a 16-bit value
+     *
+     * @return value
+     */
+    uint16_t getU16();
+
+    /**
+     * @brief Read a 32-bit value
+     *
+     * @return value
+     */
+    uint32_t getU32();
+
+    /**
+     * @brief Read a string into a buffer of the caller
+     *
+     * A string which does not fit the buffer marks the reader invalid.
+     *
+     * @param value buffer, receives the terminated string
+     * @param size buffer size in bytes, including the terminator
+     */
+    void getString(char* value, size_t size);
+
+    /**
+     * @brief Read a byte block
+     *
+     * @param size number of bytes of the block
+     * @return bytes inside the payload, nullptr after a read past the end
+     */
+    const uint8_t* getBytes(size_t& size);
+
+    /**
+     * @brief Get the number of bytes not read yet
+     *
+     * @return remaining bytes, 0 after a read past the end
+     */
+    size_t getRemaining() const;
+
+    /**
+     * @brief Check if the whole payload was read and nothing past it
+     *
+     * @return True if the payload is valid
+     */
+    bool isValid() const;
+
+  private:
+    const uint8_t* take(size_t size);
+
+    const uint8_t* mData;
+    size_t mSize;
+    size_t mPosition;
+    bool mIsOverrun;
+};
+
+#endif   // config_record_h
@@ -10,26 +10,78 @@
 
 #include <optional>
 
+#include "calibration_info.h"
+#include "config_store_stats.h"
+#include "device_config.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "led_info.h"
 #include "mutex.h"
 #include "sleep_info.h"
 #include "time_info.h"
 #include "wifi_info.h"
 
+struct cJSON;
+
 /**
  * @brief Class used for reading and writing config parameters
+ *
+ * Every section is read from flash once in initialize() and kept in RAM, so
+ * loads never touch the filesystem. Saves update the RAM copy and mark the
+ * section dirty. A flush task writes the dirty sections once the saves settle,
+ * so a burst of saves costs a single flash write per section.
+ * Every save is published on the ConfigBus, so components apply a change
+ * from the pushed value instead of loading it again.
+ *
+ * Each section is stored as a binary record, a versioned header with a CRC
+ * followed by the packed fields, so a load is a single read without parsing.
+ * A record is written to a temporary file and then renamed over the old one,
+ * so a power loss leaves either the old or the new config. Sections flushed
+ * together are first written to a journal, which is replayed on boot if the
+ * records were not all written. JSON files of older firmware are migrated to
+ * records on the first boot.
  */
 class ConfigStore {
   public:
     /**
      * @brief Initialize the module
+     *
+     * Mounts the filesystem, reads all config sections into RAM and starts
+     * the flush task.
      */
     static void initialize();
 
+    /**
+     * @brief Write the pending sections to flash immediately
+     *
+     * Used before a restart, when the flush task would be too late.
+     *
+     * @return True if all pending sections are written
+     */
+    static bool flush();
+
+    /**
+     * @brief Save several sections in a single commit
+     *
+     * The sections are written to flash before the call returns and are
+     * published afterwards, WifiInfo last.
+     *
+     * @param config sections to save, missing ones are left unchanged
+     * @return True if all sections are written
+     */
+    static bool saveConfig(const DeviceConfig& config);
+
+    /**
+     * @brief Get the write counters
+     *
+     * @return ConfigStoreStats object
+     */
+    static ConfigStoreStats getStats();
+
     /**
      * @brief Load led info
      *
-     * @param return LedInfo if the file is successfully read
+     * @param return LedInfo if it is stored, served from RAM
      */
     static std::optional<LedInfo> loadLedInfo();
 
@@ -37,14 +89,14 @@ class ConfigStore {
      * @brief Save led info
      *
      * @param ledInfo led info
-     * @return True if the config file is successfully saved
+     * @return True if the info is stored, it is written by the flush task
      */
     static bool saveLedInfo(const LedInfo& ledInfo);
 
     /**
      * @brief Load sleep info
      *
-     * @param return SleepInfo if the file is successfully read
+     * @param return SleepInfo if it is stored, served from RAM
      */
     static std::optional<SleepInfo> loadSleepInfo();
 
@@ -52,14 +104,14 @@ class ConfigStore {
      * @brief Save sleep info
      *
      * @param sleepInfo sleep info
-     * @return True if the config file is successfully saved
+     * @return True if the info is stored, it is written by the flush task
      */
     static bool saveSleepInfo(const SleepInfo& sleepInfo);
 
     /**
      * @brief Load wifi info
      *
-     * @param return WifiInfo if the file is successfully read
+     * @param return WifiInfo if it is stored, served from RAM
      */
     static std::optional<WifiInfo> loadWifiInfo();
 
@@ -67,14 +119,14 @@ class ConfigStore {
      * @brief Save wifi info
      *
      * @param wifiInfo wifi info
-     * @return True if the config file is successfully saved
+     * @return True if the info is stored, it is written by the flush task
      */
     static bool saveWifiInfo(const WifiInfo& wifiInfo);
 
     /**
      * @brief Load time info
      *
-     * @param return TimeInfo if the file is successfully read
+     * @param return TimeInfo if it is stored, served from RAM
      */
     static std::optional<TimeInfo> loadTimeInfo();
 
@@ -82,15 +134,64 @@ class ConfigStore {
      * @brief Save time info
      *
      * @param timeInfo time info
-     * @return True if the config file is successfully saved
+     * @return True if the info is stored, it is written by the flush task
      */
     static bool saveTimeInfo(const TimeInfo& timeInfo);
 
+    /**
+     * @brief Load RTC calibration info
+     *
+     * @param return CalibrationInfo if it is stored, served from RAM
+     */
+    static std::optional<CalibrationInfo> loadCalibrationInfo();
+
+    /**
+     * @brief Save RTC calibration info
+     *
+     * @param calibrationInfo calibration info
+     * @return True if the info is stored, it is written by the flush task
+     */
+    static bool saveCalibrationInfo(const CalibrationInfo& calibrationInfo);
+
   private:
     static void setupLittlefs();
+    static void markDirty(uint8_t section);
+    static void replayJournal();
+    static void flushTask(void* param);
+    static cJSON* readJson(const char* path);
+    static const uint8_t* readRecord(const char* path, uint16_t version,
+                                     size_t& length);
+    static bool writeRecord(const char* path, uint16_t version,
+                            const uint8_t* payload, size_t length);
+    static size_t encodeSection(uint8_t section, uint8_t* payload);
+
+    static std::optional<LedInfo> readLedInfo();
+    static std::optional<LedInfo> readLedInfoJson();
+    static bool writeLedInfo(const LedInfo& ledInfo);
+    static std::optional<SleepInfo> readSleepInfo();
+    static std::optional<SleepInfo> readSleepInfoJson();
+    static bool writeSleepInfo(const SleepInfo& sleepInfo);
+    static std::optional<WifiInfo> readWifiInfo();
+    static std::optional<WifiInfo> readWifiInfoJson();
+    static bool writeWifiInfo(const WifiInfo& wifiInfo);
+    static std::optional<TimeInfo> readTimeInfo();
+    static std::optional<TimeInfo> readTimeInfoJson();
+    static bool writeTimeInfo(const TimeInfo& timeInfo);
+    static std::optional<CalibrationInfo> readCalibrationInfo();
+    static std::optional<CalibrationInfo> readCalibrationInfoJson();
+    static bool writeCalibrationInfo(const CalibrationInfo& calibrationInfo);
 
+    static std::optional<LedInfo> mLedInfo;
+    static std::optional<SleepInfo> mSleepInfo;
+    static std::optional<WifiInfo> mWifiInfo;
+    static std::optional<TimeInfo> mTimeInfo;
+    static std::optional<CalibrationInfo> mCalibrationInfo;
     static bool mIsInitialized;
     static Mutex mMutex;
+    static Mutex mFlushMutex;
+    static TaskHandle_t mFlushTaskHandle;
+    static uint32_t mDirtySections;
+    static ConfigStoreStats mStats;
 };
 
 #endif   // config_store_h
\ No newline at end of file
@@ -0,0 +1,24 @@
+/******************************************************************************
+ * File:    config_store_stats.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Declaration of the config store write counters
+ ******************************************************************************/
+
+#ifndef config_store_stats_h
+#define config_store_stats_h
+
+#include <inttypes.h>
+
+/**
+ * @brief Counters of the config writes since boot
+ */
+struct ConfigStoreStats {
+    uint32_t saveCount;        ///< number of save calls
+    uint32_t writeCount;       ///< number of files written to flash
+    uint32_t coalescedCount;   ///< saves merged into a pending write
+    uint32_t failedCount;      ///< number of failed file writes
+    uint32_t pendingCount;     ///< sections waiting to be written
+};
+
+#endif   // config_store_stats_h
@@ -0,0 +1,28 @@
+/******************************************************************************
+ * File:    device_config.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Declaration of the whole device configuration
+ ******************************************************************************/
+
+#ifndef device_config_h
+#define device_config_h
+
+#include <optional>
+
+#include "led_info.h"
+#include "sleep_info.h"
+#include "time_info.h"
+#include "wifi_info.h"
+
+/**
+ * @brief User configurable sections, a missing section is left unchanged
+ */
+struct DeviceConfig {
+    std::optional<LedInfo> ledInfo;       ///< backlight
+    std::optional<SleepInfo> sleepInfo;   ///< sleep window
+    std::optional<TimeInfo> timeInfo;     ///< time zone and NTP servers
+    std::optional<WifiInfo> wifiInfo;     ///< station configuration
+};
+
+#endif   // device_config_h
@@ -0,0 +1,117 @@
+/******************************************************************************
+ * File:    digit_sequencer.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Declaration of a hardware timer driven nixie tube sequencer
+ ******************************************************************************/
+
+#ifndef digit_sequencer_h
+#define digit_sequencer_h
+
+#include <inttypes.h>
+
+#include "driver/gptimer.h"
+#include "freertos/FreeRTOS.h"
+
+#include "in14_nixie_tube.h"
+
+/**
+ * @brief A precompiled display frame
+ */
+struct DisplayFrame {
+    uint8_t code;          ///< code written to the BCD decoder
+    uint32_t durationUs;   ///< how long the frame lasts
+};
+
+/**
+ * @brief Statistics of the frame edges, measured in the timer ISR
+ *
+ * Latency is the time between the scheduled edge (alarm) and the moment the
+ * new code was written to the GPIOs.
+ */
+struct SequencerStats {
+    uint32_t sequences;      ///< number of played sequences
+    uint32_t edges;          ///< number of frame edges
+    uint32_t maxLatencyUs;   ///< worst edge latency
+    uint32_t avgLatencyUs;   ///< average edge latency
+};
+
+/**
+ * @brief Plays an array of frames on the nixie tube from a gptimer ISR
+ *
+ * Every frame edge is an alarm of a free running 1 MHz timer. The next alarm
+ * is set relative to the previous one, so the edges do not accumulate the
+ * interrupt latency and do not depend on the scheduler load.
+ */
+class DigitSequencer {
+  public:
+    /**
+     * @brief Called from the ISR after the last frame
+     *
+     * Returns true if a higher priority task was woken up.
+     */
+    using DoneCallback = bool (*)(void* arg);
+
+    /**
+     * @brief Construct a new Digit Sequencer object
+     *
+     * @param tube nixie tube to drive
+     */
+    DigitSequencer(In14NixieTube& tube);
+
+    /**
+     * @brief Create the timer
+     *
+     * @param callback callback called from the ISR when a sequence ends
+     * @param arg argument passed to the callback
+     */
+    void initialize(DoneCallback callback, void* arg);
+
+    /**
+     * @brief Start playing frames
+     *
+     * The tube is blanked after the last frame.
+     *
+     * @param frames frames, have to stay valid until the sequence ends
+     * @param count number of frames
+     * @return True if the sequence is started
+     */
+    bool start(const DisplayFrame* frames, uint16_t count);
+
+    /**
+     * @brief Stop the sequence in progress, disable the timer and blank the
+     * tube
+     *
+     * Has to be called after every sequence, also a finished one. Not
+     * callable from an ISR.
+     */
+    void stop();
+
+    /**
+     * @brief Get edge timing statistics
+     *
+     * @return statistics
+     */
+    SequencerStats getStats();
+
+  private:
+    static constexpr uint32_t kStartDelayUs = 50;
+
+    static bool onAlarm(gptimer_handle_t timer,
+                        const gptimer_alarm_event_data_t* edata, void* arg);
+
+    In14NixieTube& mTube;
+    gptimer_handle_t mTimer;
+    DoneCallback mCallback;
+    void* mCallbackArg;
+    const DisplayFrame* mFrames;
+    volatile uint16_t mCount;
+    volatile uint16_t mIndex;
+    volatile bool mIsRunning;
+    bool mIsEnabled;
+    uint64_t mLatencySumUs;
+    SequencerStats mStats;
+    portMUX_TYPE mSpinlock;
+};
+
+#endif   // digit_sequencer_h
@@ -0,0 +1,173 @@
+/******************************************************************************
+ * File:    display_worker.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Declaration of a persistent task driving the nixie tube
+ ******************************************************************************/
+
+#ifndef display_worker_h
+#define display_worker_h
+
+#include <atomic>
+#include <inttypes.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "digit_sequencer.h"
+#include "in14_nixie_tube.h"
+
+/**
+ * @brief Maximum number of steps in a single display sequence
+ */
+static constexpr uint8_t kMaxDisplaySteps = 48;
+
+/**
+ * @brief A single step of a display sequence
+ */
+struct DisplayStep {
+    int8_t digit;          ///< digit between 0 and 9, negative for blank
+    uint16_t durationMs;   ///< how long the step lasts
+};
+
+/**
+ * @brief Receives notifications about display jobs
+ *
+ * Called from the display task.
+ */
+class IDisplayListener {
+  public:
+    /**
+     * @brief Default destructor
+     */
+    virtual ~IDisplayListener() = default;
+
+    /**
+     * @brief Called before the first step of a display job
+     */
+    virtual void onDisplayStarted() = 0;
+
+    /**
+     * @brief Called after the last step of a display job or when the job was
+     * interrupted
+     */
+    virtual void onDisplayFinished() = 0;
+};
+
+/**
+ * @brief Statically allocated task playing display jobs on the nixie tube
+ *
+ * Jobs are posted through a FreeRTOS queue and started by a task that lives
+ * for the whole lifetime of the application, so starting a job needs no
+ * allocation. A new request interrupts the job in progress.
+ *
+ * A job is compiled into display frames which are played by DigitSequencer,
+ * the task itself only waits for the end of the sequence.
+ */
+class DisplayWorker {
+  public:
+    /**
+     * @brief Construct a new Display Worker object
+     *
+     * @param tube nixie tube to drive
+     * @param listener display job listener
+     */
+    DisplayWorker(In14NixieTube& tube, IDisplayListener& listener);
+
+    /**
+     * @brief Create the queue and start the task
+     */
+    void initialize();
+
+    /**
+     * @brief Show the intro followed by the time
+     *
+     * @param hour hour to show, already converted to the desired format
+     * @param minute minute to show
+     * @return True if the request is queued
+     */
+    bool showTime(uint8_t hour, uint8_t minute);
+
+    /**
+     * @brief Show the intro, a fast countdown from 9 to 0
+     *
+     * @return True if the request is queued
+     */
+    bool showIntro();
+
+    /**
+     * @brief Show an arbitrary sequence
+     *
+     * @param steps sequence steps
+     * @param count number of steps, at most kMaxDisplaySteps
+     * @return True if the request is queued
+     */
+    bool showSequence(const DisplayStep* steps, uint8_t count);
+
+    /**
+     * @brief Stop the job in progress and blank the tube
+     *
+     * @return True if the request is queued
+     */
+    bool cancel();
+
+    /**
+     * @brief Check if a job is in progress
+     *
+     * @return True if the tube is busy
+     */
+    bool isBusy() const;
+
+    /**
+     * @brief Get edge timing statistics of the sequencer
+     *
+     * @return statistics
+     */
+    SequencerStats getSequencerStats();
+
+  private:
+    enum class CommandType : uint8_t {
+        ShowTime,
+        ShowIntro,
+        ShowSequence,
+        Cancel,
+        SequenceDone
+    };
+
+    struct Command {
+        CommandType type;
+        uint32_t jobId;
+        uint8_t hour;
+        uint8_t minute;
+        uint8_t stepCount;
+        DisplayStep steps[kMaxDisplaySteps];
+    };
+
+    static constexpr uint32_t kQueueLength = 4;
+    static constexpr uint32_t kStackSize = 4096;
+
+    static void task(void* param);
+    static bool onSequenceDone(void* param);
+    bool post(const Command& command);
+    void execute(const Command& command);
+    uint8_t composeIntro(DisplayStep* steps);
+    uint8_t composeTime(DisplayStep* steps, uint8_t hour, uint8_t minute);
+    void play(const DisplayStep* steps, uint8_t count);
+
+    In14NixieTube& mTube;
+    IDisplayListener& mListener;
+    DigitSequencer mSequencer;
+    std::atomic<bool> mIsBusy;
+    uint32_t mJobId;
+    QueueHandle_t mQueue;
+    StaticQueue_t mQueueBuffer;
+    uint8_t mQueueStorage[kQueueLength * sizeof(Command)];
+    StackType_t mStack[kStackSize];
+    StaticTask_t mTaskBuffer;
+    Command mCommand;
+    Command mDoneCommand;
+    DisplayFrame mFrames[kMaxDisplaySteps];
+};
+
+#endif   // display_worker_h
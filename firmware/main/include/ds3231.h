@@ -12,8 +12,30 @@
 
 #include <ctime>
 
+#include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
+
+#include "mutex.h"
+#include "temperature_history.h"
+
+/**
+ * @brief Driver of the DS3231 real-time clock.
+ *
+ * The driver keeps a RAM mirror of the whole register map (0x00-0x12).
+ * Reads refresh a register range of the mirror in one write-read
+ * transaction, register updates are read-modify-write against the mirror
+ * and only write registers which change.
+ */
 class Ds3231 {
   public:
+    /**
+     * @brief Called from the GPIO ISR when the minute alarm fires
+     */
+    using AlarmCallback = void (*)(void* arg);
+
+    static constexpr uint8_t kRegisterCount = 0x13;
+    static constexpr uint32_t kTemperatureInterval = 64;   // conversion, s
+
     /**
      * @brief Construct the DS3231 driver using a shared I2C bus.
      * @param i2c Reference to an initialized I2C object.
@@ -21,10 +43,65 @@ class Ds3231 {
     Ds3231(I2cBus& bus);
 
     /**
-     * @brief Initialize the module
+     * @brief Initialize the module and read the whole register map
      */
     void initialize();
 
+    /**
+     * @brief Read a register range into the mirror in one transaction.
+     * @param first first register address.
+     * @param count number of registers.
+     * @return true on success, false otherwise.
+     */
+    bool refresh(uint8_t first = 0, uint8_t count = kRegisterCount);
+
+    /**
+     * @brief Get a register value from the mirror without bus access.
+     * @param reg register address.
+     * @return mirrored register value.
+     */
+    uint8_t getRegister(uint8_t reg);
+
+    /**
+     * @brief Read-modify-write a register against the mirror.
+     *
+     * The register is written only if its value changes.
+     *
+     * @param reg register address.
+     * @param mask bits to update.
+     * @param value new value of the masked bits.
+     * @return true on success, false otherwise.
+     */
+    bool updateRegister(uint8_t reg, uint8_t mask, uint8_t value);
+
+    /**
+     * @brief Check the oscillator stop flag from the mirror.
+     *
+     * The flag is set when the oscillator stopped (e.g. the backup battery
+     * was empty) and cleared by setTime().
+     *
+     * @return true if the time kept by the RTC is not valid.
+     */
+    bool hasOscillatorStopped();
+
+    /**
+     * @brief Read the temperature registers and append them to the history.
+     *
+     * The RTC converts the temperature every kTemperatureInterval seconds,
+     * sampling more often only repeats the same value. The time registers
+     * are not touched.
+     *
+     * @return true on success, false otherwise.
+     */
+    bool sampleTemperature();
+
+    /**
+     * @brief Get statistics of the sampled temperature.
+     * @param points maximum number of points of the downsampled series.
+     * @return TemperatureStats object.
+     */
+    TemperatureStats getTemperatureStats(size_t points) const;
+
     /**
      * @brief Read current time and date from the RTC.
      * @param[out] timeinfo Pointer to a struct tm to receive the data.
@@ -39,12 +116,76 @@ class Ds3231 {
      */
     bool setTime(const struct tm* timeinfo);
 
+    /**
+     * @brief Enable the 1 Hz square-wave output and timestamp its edges.
+     *
+     * The seconds register increments on the falling edge of the SQW output,
+     * the edge is captured by a GPIO interrupt with esp_timer_get_time().
+     *
+     * @param sqwPin GPIO connected to the SQW/INT pin of the DS3231.
+     * @return ESP_OK on success, an error code otherwise.
+     */
+    esp_err_t enableSquareWave(gpio_num_t sqwPin);
+
+    /**
+     * @brief Fire Alarm 2 at every full minute on the INT pin.
+     *
+     * Replaces the square wave, the INT pin is the same as SQW. The pin
+     * also wakes the chip from light sleep. The alarm keeps the pin low
+     * until acknowledgeAlarm() is called, so the GPIO interrupt is disabled
+     * in the ISR and enabled again there.
+     *
+     * @param intPin GPIO connected to the SQW/INT pin of the DS3231.
+     * @param callback callback called from the ISR.
+     * @param arg argument passed to the callback.
+     * @return ESP_OK on success, an error code otherwise.
+     */
+    esp_err_t enableMinuteAlarm(gpio_num_t intPin, AlarmCallback callback,
+                                void* arg);
+
+    /**
+     * @brief Clear the alarm flag and re-arm the GPIO interrupt.
+     * @return true on success, false otherwise.
+     */
+    bool acknowledgeAlarm();
+
+    /**
+     * @brief Get the timestamp of the last second boundary of the RTC.
+     *
+     * With the minute alarm enabled only full minutes are captured.
+     *
+     * @return esp_timer_get_time() at the last SQW falling edge, 0 if no edge
+     * was captured yet.
+     */
+    int64_t getLastEdgeUs();
+
+    /**
+     * @brief Program the aging offset register.
+     *
+     * One LSB changes the oscillator frequency by about 0.1 ppm, a positive
+     * value slows the clock down. A temperature conversion is started so the
+     * new value is applied right away.
+     *
+     * @param offset signed aging offset.
+     * @return true on success, false otherwise.
+     */
+    bool setAgingOffset(int8_t offset);
+
   private:
-    uint8_t bcd2dec(uint8_t val);
-    uint8_t dec2bcd(uint8_t val);
+    bool writeRegisters(uint8_t first, const uint8_t* values, uint8_t count);
+    static void onSquareWaveEdge(void* arg);
+    static void onAlarmEdge(void* arg);
 
     I2cBus& mBus;
     i2c_master_dev_handle_t mDevHandle;
+    uint8_t mRegisters[kRegisterCount];
+    Mutex mMutex;
+    TemperatureHistory mTemperatureHistory;
+    gpio_num_t mIntPin;
+    AlarmCallback mAlarmCallback;
+    void* mAlarmArg;
+    int64_t mLastEdgeUs;
+    portMUX_TYPE mSpinlock;
 };
 
 #endif   // ds3231_h
\ No newline at end of file
@@ -77,7 +77,8 @@ class I2cBus {
      * @brief Read data from an I2C device, optionally after writing a register
      * address.
      *
-     * Performs a combined write-read transaction if @p reg_len > 0.
+     * Performs a combined write-read transaction (repeated start) if
+     * @p reg_len > 0.
      *
      * @param dev Device handle obtained from addDevice().
      * @param reg Optional pointer to the register address buffer (can be
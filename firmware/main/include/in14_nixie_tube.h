@@ -50,6 +50,23 @@ class In14NixieTube {
      */
     void hideDigit();
 
+    /**
+     * @brief Convert a digit to the code of the BCD decoder
+     *
+     * @param digit A number between 0 and 9
+     * @return decoder code, NONE if the digit is out of range
+     */
+    static uint8_t toCode(uint8_t digit);
+
+    /**
+     * @brief Write a decoder code obtained with toCode() directly
+     *
+     * Safe to call from an ISR.
+     *
+     * @param code decoder code
+     */
+    void writeCode(uint8_t code);
+
   private:
     BCD2DecimalDecoder mDecoder;
 };
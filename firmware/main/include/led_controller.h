@@ -8,18 +8,38 @@
 #ifndef led_controller_h
 #define led_controller_h
 
+#include <atomic>
 #include <inttypes.h>
-#include <optional>
 
 #include "driver/gpio.h"
+#include "driver/rmt_tx.h"
 
 #include "led_info.h"
-#include "led_strip.h"
 #include "mutex.h"
+#include "seq_lock.h"
+
+/**
+ * @brief Frame counters of the LED controller
+ */
+struct LedFrameStats {
+    uint32_t rendered;   ///< frames computed by update()
+    uint32_t sent;       ///< frames actually sent to the LED
+};
 
 /**
  * @brief A driver class for handling the RGB led
  *
+ * The base and the temporal LED state are published through a SeqLock, so
+ * update() never blocks on a setter. Setters are serialized by a mutex.
+ *
+ * Frames are encoded into WS2812 RMT symbols by the controller itself and
+ * queued to the RMT channel without waiting for the transmission. Two symbol
+ * buffers are used, a buffer is released in the transmit done callback.
+ *
+ * One period of the Fade and Pulse effects is precomputed into a table of
+ * distinct frames with their hold times, which is rebuilt only when the
+ * effect color or state changes. update() therefore runs once per distinct
+ * frame instead of once per animation step.
  */
 class LedController {
   public:
@@ -37,14 +57,24 @@ class LedController {
      */
     void initialize(LedInfo ledInfo);
 
+    /**
+     * @brief Run the color sweep test of the LED
+     *
+     * Blocks for about 2 seconds and must not run concurrently with update().
+     */
+    void test();
+
     /**
      * @brief This is the loop method of the class.
      *
      * It is updating the actual led state (color and brightness)accoring to led
      * state.
      *
+     * @return Time in milliseconds after which update() has to be called
+     * again to show the next frame of an animated effect or to release the
+     * RMT channel after a static frame, 0 if nothing is left to do.
      */
-    void update();
+    uint32_t update();
 
     /**
      * @brief Set the Led Info object
@@ -72,16 +102,59 @@ class LedController {
      */
     void clearTemporalState();
 
+    /**
+     * @brief Get the rendered and sent frame counters
+     *
+     * A frame identical to the last sent one is rendered but not sent.
+     *
+     * @return frame counters
+     */
+    LedFrameStats getFrameStats() const;
+
   private:
-    void test();
+    // 24 data bits and one reset symbol
+    static constexpr size_t kFrameSymbols = 25;
+    // brightness ramp up and down, one step per frame period
+    static constexpr size_t kEffectSteps = 512;
+
+    struct LedStates {
+        LedInfo base;
+        LedInfo temporal;
+        bool hasTemporal;
+    };
+
+    struct EffectFrame {
+        uint8_t red;
+        uint8_t green;
+        uint8_t blue;
+        uint16_t holdMs;
+    };
+
+    void sendFrame(uint8_t r, uint8_t g, uint8_t b);
+    bool releaseChannel();
+    void buildEffect(const LedInfo& ledInfo);
+    static bool onTransmitDone(rmt_channel_handle_t channel,
+                               const rmt_tx_done_event_data_t* edata,
+                               void* param);
 
     gpio_num_t mLedPin;
-    led_strip_handle_t mLedHandle;
-    LedInfo mLedInfo;
-    uint8_t mCounter;
-    bool mDirection;
-    std::optional<LedInfo> mTempState;
-    Mutex mMutex;
+    rmt_channel_handle_t mChannel;
+    rmt_encoder_handle_t mEncoder;
+    rmt_symbol_word_t mSymbols[2][kFrameSymbols];
+    std::atomic<bool> mIsBufferBusy[2];
+    bool mIsChannelEnabled;
+    uint8_t mWriteIndex;
+    uint8_t mDoneIndex;
+    LedInfo mEffectInfo;
+    EffectFrame mEffectFrames[kEffectSteps];
+    uint16_t mEffectFrameCount;
+    uint16_t mEffectIndex;
+    uint8_t mLastFrame[3];
+    bool mHasLastFrame;
+    std::atomic<uint32_t> mFramesRendered;
+    std::atomic<uint32_t> mFramesSent;
+    SeqLock<LedStates> mStates;
+    Mutex mWriterMutex;
 };
 
 #endif   // led_controller_h
\ No newline at end of file
@@ -1,25 +1,33 @@
 #ifndef nixie_clock_h
 #define nixie_clock_h
 
+#include <atomic>
 #include <optional>
 
 #include "esp_event.h"   //for wifi event
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include "clock_discipline.h"
 #include "clock_iface.h"
+#include "display_worker.h"
 #include "ds3231.h"
 #include "i2c_bus.h"
 #include "in14_nixie_tube.h"
 #include "led_controller.h"
 #include "mutex.h"
+#include "pm_lock.h"
+#include "rtc_calibrator.h"
 #include "sleep_info.h"
+#include "sntp_manager.h"
 #include "time_info.h"
+#include "time_keeper.h"
 #include "web_server.h"
 #include "wifi_info.h"
 #include "wifi_manager.h"
 
-class NixieClock : public IClock {
+class NixieClock : public IClock, public IDisplayListener {
   public:
     NixieClock();
     ~NixieClock() = default;
@@ -33,29 +41,70 @@ class NixieClock : public IClock {
     virtual void onSetWifiInfo(const WifiInfo& wifiInfo) override;
     virtual std::optional<TimeInfo> onGetTimeInfo() const override;
     virtual void onSetTimeInfo(const TimeInfo& timeInfo) override;
+    virtual DeviceConfig onGetConfig() const override;
+    virtual void onSetConfig(const DeviceConfig& config) override;
+    virtual SyncStatus onGetSyncStatus() const override;
+    virtual TemperatureStats
+    onGetTemperatureStats(size_t points) const override;
+    virtual ConfigStoreStats onGetConfigStoreStats() const override;
+    virtual void onDisplayStarted() override;
+    virtual void onDisplayFinished() override;
 
   private:
     void setupCaptivePortal();
     void startMdnsService(const WifiInfo& wifiInfo);
     void initializeSNTP();
-    static void timeSyncNotificationCallback(struct timeval* tv);
+    static void bootTask(void* param);
+    void startNetwork();
+    bool setSystemTimeFromRtc();
+    static void timeSyncCallback(void* param);
     bool isInSleepMode();
     static void loopTask(void* param);
-    bool startShowCurrentTimeTask(void);
-    static void showCurrentTimeTask(void* param);
+    static void timeTickCallback(const TimeSnapshot& snapshot, void* param);
+    static void ledTimerCallback(void* param);
+    static void sleepTimerCallback(void* param);
+    static void temperatureTimerCallback(void* param);
+    bool enableLowPowerMode();
+    static void minuteAlarmCallback(void* param);
+    void handleMinuteAlarm();
+    void scheduleSleepTransition();
+    void requestLedUpdate();
+    void handleLedFrame();
+    void handleMinuteTick();
+    void showCurrentTime();
     void handleSleepMode();
-    time_t timegmRtc(struct tm* tm);
+    static void ledInfoCallback(const LedInfo& ledInfo, void* param);
+    static void sleepInfoCallback(const SleepInfo& sleepInfo, void* param);
+    static void wifiInfoCallback(const WifiInfo& wifiInfo, void* param);
+    static void timeInfoCallback(const TimeInfo& timeInfo, void* param);
 
     LedController mLedController;
     In14NixieTube mNixieTube;
+    DisplayWorker mDisplayWorker;
     WifiManager mWifiManager;
     WebServer mWebServer;
+    LedInfo mLedInfo;
     SleepInfo mSleepInfo;
     TimeInfo mTimeInfo;
-    TaskHandle_t mShowCurrentTimeTaskHandle;
+    TaskHandle_t mLoopTaskHandle;
+    TimeKeeper mTimeKeeper;
+    int32_t mLastMinuteOfDay;
+    esp_timer_handle_t mLedTimer;
+    esp_timer_handle_t mSleepTimer;
+    esp_timer_handle_t mTemperatureTimer;
+    uint32_t mLoopWakeups;
     I2cBus mI2c;
     Ds3231 mRtc;
-    bool mLastSleepModeStatus;
+    RtcCalibrator mRtcCalibrator;
+    ClockDiscipline mClockDiscipline;
+    SntpManager mSntpManager;
+    std::atomic<bool> mLastSleepModeStatus;
+    std::atomic<bool> mIsLedReady;
+    std::atomic<bool> mIsTimeValid;
+    bool mIsFirstDigitShown;
+    PmLock mDisplayPmLock;
+    PmLock mLedPmLock;
+    int64_t mBootStartUs;
     mutable Mutex mMutex;
 };
 #endif   // nixie_clock_h
\ No newline at end of file
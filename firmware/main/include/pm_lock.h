@@ -0,0 +1,58 @@
+/******************************************************************************
+ * File:    pm_lock.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Declaration of a power management lock wrapper class
+ ******************************************************************************/
+
+#ifndef pm_lock_h
+#define pm_lock_h
+
+#include <atomic>
+
+#include "esp_pm.h"
+
+/**
+ * @brief Idempotent wrapper of an esp_pm lock
+ *
+ * While the lock is held the chip does not enter automatic light sleep.
+ * acquire() and release() can be called repeatedly, the underlying lock is
+ * taken at most once. Without CONFIG_PM_ENABLE the class does nothing.
+ *
+ * @note
+ * - This class is not copyable or movable.
+ */
+class PmLock {
+  public:
+    /**
+     * @brief Create the lock.
+     *
+     * @param name name shown by esp_pm_dump_locks().
+     */
+    explicit PmLock(const char* name);
+
+    /**
+     * @brief Delete the lock.
+     */
+    ~PmLock();
+
+    /// @brief Non-copyable
+    PmLock(const PmLock&) = delete;
+    PmLock& operator=(const PmLock&) = delete;
+
+    /**
+     * @brief Take the lock if it is not held yet.
+     */
+    void acquire();
+
+    /**
+     * @brief Give the lock back if it is held.
+     */
+    void release();
+
+  private:
+    esp_pm_lock_handle_t mHandle;
+    std::atomic<bool> mIsHeld;
+};
+
+#endif   // pm_lock_h
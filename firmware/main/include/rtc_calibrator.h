@@ -0,0 +1,89 @@
+/******************************************************************************
+ * File:    rtc_calibrator.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Declaration of a service calibrating the RTC from NTP history
+ ******************************************************************************/
+
+#ifndef rtc_calibrator_h
+#define rtc_calibrator_h
+
+#include <atomic>
+#include <ctime>
+#include <inttypes.h>
+
+#include "calibration_info.h"
+#include "ds3231.h"
+#include "mutex.h"
+
+/**
+ * @brief Trims the DS3231 aging offset from the RTC drift against NTP
+ *
+ * After every NTP sync the offset of the RTC against the synchronized system
+ * time is added as a sample. The RTC is rewritten only when the offset grows
+ * too large, rewrites are accounted for so the samples form one continuous
+ * phase series. The drift rate is fitted over the series with least squares
+ * and compensated through the aging offset register.
+ *
+ * The calibration is persisted. While the drift stays low the recommended
+ * NTP sync interval is doubled up to one day.
+ */
+class RtcCalibrator {
+  public:
+    /**
+     * @brief Construct a new Rtc Calibrator object
+     *
+     * @param rtc initialized RTC driver
+     */
+    RtcCalibrator(Ds3231& rtc);
+
+    /**
+     * @brief Load the persisted calibration and program the RTC
+     *
+     * The ConfigStore has to be initialized.
+     */
+    void initialize();
+
+    /**
+     * @brief Add an RTC offset measured right after an NTP sync
+     *
+     * @param utc synchronized time of the measurement
+     * @param offsetUs RTC time minus system time in microseconds
+     * @return True if the RTC has to be rewritten
+     */
+    bool addSample(time_t utc, int64_t offsetUs);
+
+    /**
+     * @brief Get the recommended NTP sync interval
+     *
+     * @return interval in milliseconds
+     */
+    uint32_t getSyncInterval() const;
+
+    /**
+     * @brief Get the current calibration
+     *
+     * @return calibration info
+     */
+    CalibrationInfo getCalibrationInfo() const;
+
+  private:
+    static constexpr uint8_t kMaxSamples = 16;
+
+    struct Sample {
+        time_t utc;
+        int64_t phaseUs;
+    };
+
+    void fit();
+
+    Ds3231& mRtc;
+    CalibrationInfo mInfo;
+    Sample mSamples[kMaxSamples];
+    uint8_t mSampleCount;
+    int64_t mCorrectionUs;
+    std::atomic<uint32_t> mSyncInterval;
+    mutable Mutex mMutex;
+};
+
+#endif   // rtc_calibrator_h
@@ -0,0 +1,89 @@
+/******************************************************************************
+ * File:    seq_lock.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Double buffered sequence lock for lock-free snapshot publishing
+ ******************************************************************************/
+
+#ifndef seq_lock_h
+#define seq_lock_h
+
+#include <atomic>
+#include <inttypes.h>
+#include <type_traits>
+
+/**
+ * @brief Publishes a value from one writer to many readers without locks
+ *
+ * The value is kept in two buffers. The writer always fills the buffer that
+ * is not published and then publishes it by bumping the sequence counter, so
+ * the writer never waits. A reader copies the published buffer and retries
+ * only if the writer started overwriting that very buffer in the meantime,
+ * which requires two stores to happen during a single read.
+ *
+ * The sequence counter is incremented twice per store. An odd value means a
+ * store is in progress, the published buffer is selected by bit 1.
+ *
+ * @note
+ * - Stores must be serialized by the caller (single writer).
+ * - T has to be trivially copyable.
+ */
+template <typename T> class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SeqLock requires a trivially copyable type");
+
+  public:
+    /**
+     * @brief Construct a new SeqLock holding a value initialized T
+     */
+    SeqLock() : mSequence(0), mBuffers{} {}
+
+    /**
+     * @brief Publish a new value
+     *
+     * @param value value to publish
+     */
+    void store(const T& value) {
+        uint32_t sequence = mSequence.load(std::memory_order_relaxed);
+        mSequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        mBuffers[((sequence >> 1) + 1) & 1] = value;
+        mSequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief Read the last published value
+     *
+     * @return copy of the published value
+     */
+    T load() const {
+        T value;
+        uint32_t before;
+        uint32_t after;
+        do {
+            before = mSequence.load(std::memory_order_acquire);
+            value = mBuffers[(before >> 1) & 1];
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = mSequence.load(std::memory_order_relaxed);
+        } while (after - (before & ~1u) > 2);
+        return value;
+    }
+
+    /**
+     * @brief Get the generation counter
+     *
+     * The generation is incremented by every completed store and can be used
+     * by readers to cheaply detect a change.
+     *
+     * @return number of completed stores
+     */
+    uint32_t generation() const {
+        return mSequence.load(std::memory_order_acquire) >> 1;
+    }
+
+  private:
+    std::atomic<uint32_t> mSequence;
+    T mBuffers[2];
+};
+
+#endif   // seq_lock_h
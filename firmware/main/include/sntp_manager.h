@@ -0,0 +1,123 @@
+/******************************************************************************
+ * File:    sntp_manager.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Declaration of a class managing the SNTP time synchronization
+ ******************************************************************************/
+
+#ifndef sntp_manager_h
+#define sntp_manager_h
+
+#include <atomic>
+#include <inttypes.h>
+#include <string>
+#include <sys/time.h>
+#include <vector>
+
+#include "mutex.h"
+#include "sync_status.h"
+
+/**
+ * @brief Manages the SNTP client of ESP-IDF
+ *
+ * - The configured servers are probed and handed to SNTP ordered by their
+ *   measured round-trip time, the fastest one is queried first.
+ * - The time received from NTP is applied by this class (sntp_sync_time is
+ *   overridden): small offsets are slewed with adjtime(), only large ones are
+ *   stepped, so the minute ticks are neither skipped nor repeated.
+ * - The poll interval is doubled while the offsets stay small and halved
+ *   when they grow. It stays between 15 minutes and the ceiling set by the
+ *   owner, e.g. from the measured RTC drift.
+ */
+class SntpManager {
+  public:
+    /**
+     * @brief Callback invoked after every sync from the lwIP task
+     *
+     * Runs after the time was applied and before the next poll interval is
+     * chosen, so a ceiling set from it applies to the next poll already.
+     */
+    using SyncCallback = void (*)(void* arg);
+
+    /**
+     * @brief Construct a new Sntp Manager object
+     */
+    SntpManager();
+
+    /**
+     * @brief Probe the servers and start SNTP
+     *
+     * Blocks while the servers are probed (up to one second per server).
+     *
+     * @param servers host names of the NTP servers
+     * @param callback sync callback
+     * @param arg argument passed to the callback
+     */
+    void initialize(const std::vector<std::string>& servers,
+                    SyncCallback callback, void* arg);
+
+    /**
+     * @brief Replace the server list
+     *
+     * The servers are probed and SNTP is restarted from a background task,
+     * an unchanged list is ignored. A single probe task runs at a time, a
+     * list set while it probes is applied when the probe is done.
+     *
+     * @param servers host names of the NTP servers
+     */
+    void setServers(const std::vector<std::string>& servers);
+
+    /**
+     * @brief Set the upper bound of the poll interval
+     *
+     * Unstable offsets still shorten the interval below this value.
+     *
+     * @param interval interval in milliseconds, clamped to 15 min - 1 day
+     */
+    void setMaxSyncInterval(uint32_t interval);
+
+    /**
+     * @brief Get the synchronization status
+     *
+     * @return status, the RTC fields are left zeroed
+     */
+    SyncStatus getStatus() const;
+
+    /**
+     * @brief Apply the time received from NTP
+     *
+     * Called by the sntp_sync_time() override only.
+     *
+     * @param tv time received from the server
+     */
+    void syncTime(struct timeval* tv);
+
+  private:
+    static constexpr uint8_t kMaxServers = CONFIG_LWIP_SNTP_MAX_SERVERS;
+    static constexpr size_t kMaxServerNameLen = 64;
+
+    static void probeTask(void* param);
+    void probeAndStart();
+    static int32_t measureRtt(const std::string& server);
+    uint32_t adaptSyncInterval(int64_t offsetUs);
+
+    SyncCallback mCallback;
+    void* mCallbackArg;
+    std::vector<std::string> mPendingServers;
+    bool mHasPendingServers;   // set since the last probe started
+    bool mIsProbeRunning;
+    std::vector<NtpServerStatus> mServers;
+    // SNTP keeps pointers to the server names
+    char mServerNames[kMaxServers][kMaxServerNameLen];
+    std::atomic<bool> mIsStarted;
+    uint32_t mSyncCount;
+    time_t mLastSync;
+    int64_t mLastOffsetUs;
+    bool mWasStepped;
+    uint32_t mSyncInterval;
+    uint32_t mMaxSyncInterval;
+    uint8_t mStableCount;
+    mutable Mutex mMutex;
+};
+
+#endif   // sntp_manager_h
@@ -0,0 +1,39 @@
+/******************************************************************************
+ * File:    sync_status.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Declaration of the time synchronization status
+ ******************************************************************************/
+
+#ifndef sync_status_h
+#define sync_status_h
+
+#include <ctime>
+#include <inttypes.h>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Round-trip time of an NTP server
+ */
+struct NtpServerStatus {
+    std::string name;   ///< host name
+    int32_t rttMs;      ///< round-trip time, -1 if the server did not reply
+};
+
+/**
+ * @brief Status of the NTP time synchronization and of the RTC calibration
+ */
+struct SyncStatus {
+    bool isSynced;                          ///< at least one sync happened
+    uint32_t syncCount;                     ///< number of syncs since boot
+    time_t lastSync;                        ///< time of the last sync
+    int64_t lastOffsetUs;                   ///< NTP minus system time
+    bool wasStepped;                        ///< last correction was a step
+    uint32_t syncInterval;                  ///< current poll interval in ms
+    std::vector<NtpServerStatus> servers;   ///< servers ordered by preference
+    int32_t rtcDriftPpb;                    ///< last fitted RTC drift
+    int8_t rtcAgingOffset;                  ///< DS3231 aging offset
+};
+
+#endif   // sync_status_h
@@ -0,0 +1,73 @@
+/******************************************************************************
+ * File:    temperature_history.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Declaration of a ring buffer of temperature samples
+ ******************************************************************************/
+
+#ifndef temperature_history_h
+#define temperature_history_h
+
+#include <cstddef>
+#include <inttypes.h>
+#include <vector>
+
+#include "mutex.h"
+
+/**
+ * @brief Summary of the temperature history
+ */
+struct TemperatureStats {
+    uint32_t sampleCount;        ///< number of samples in the history
+    uint32_t sampleInterval;     ///< time between samples in seconds
+    float current;               ///< last sample in degrees Celsius
+    float min;                   ///< lowest sample in degrees Celsius
+    float max;                   ///< highest sample in degrees Celsius
+    float average;               ///< average of all samples
+    std::vector<float> series;   ///< downsampled history, oldest first
+};
+
+/**
+ * @brief Fixed size history of temperature samples
+ *
+ * Samples are kept in the DS3231 resolution (0.25 degrees Celsius) as 16 bit
+ * values, the oldest sample is overwritten when the history is full.
+ */
+class TemperatureHistory {
+  public:
+    static constexpr size_t kCapacity = 1350;   // 24 h of 64 s samples
+
+    /**
+     * @brief Construct an empty history
+     */
+    TemperatureHistory();
+
+    /**
+     * @brief Append a sample
+     *
+     * @param quarterDegrees temperature in 0.25 degrees Celsius
+     */
+    void add(int16_t quarterDegrees);
+
+    /**
+     * @brief Compute the statistics and a downsampled series
+     *
+     * The history is split into at most @p points equally long buckets, the
+     * series contains the average of each bucket.
+     *
+     * @param points maximum number of series points, 0 for no series
+     * @param sampleInterval time between samples in seconds
+     * @return TemperatureStats object
+     */
+    TemperatureStats getStats(size_t points, uint32_t sampleInterval) const;
+
+  private:
+    int16_t at(size_t index) const;
+
+    int16_t mSamples[kCapacity];
+    size_t mHead;
+    size_t mCount;
+    mutable Mutex mMutex;
+};
+
+#endif   // temperature_history_h
@@ -9,7 +9,9 @@
 #define time_info_h
 
 #include <inttypes.h>
+#include <stddef.h>
 #include <string>
+#include <vector>
 
 /**
  * @brief An enumeration representing time formats
@@ -34,9 +36,23 @@ constexpr const char* timeFormatToString(TimeFormat tf) {
 /**
  * @brief Represents a data class used for storing time related config
  *
+ * The strings are kept in fixed-size buffers, so the class owns no heap and
+ * copying it is a plain memory copy.
  */
 class TimeInfo {
   public:
+    /// @brief Buffer size of the zone name, including the terminator
+    static constexpr size_t kTzZoneSize = 48;
+
+    /// @brief Buffer size of the POSIX TZ rule, including the terminator
+    static constexpr size_t kTzOffsetSize = 64;
+
+    /// @brief Maximum number of NTP servers
+    static constexpr uint8_t kMaxNtpServers = 4;
+
+    /// @brief Buffer size of an NTP server name, including the terminator
+    static constexpr size_t kNtpServerSize = 64;
+
     /**
      * @brief Default constructor
      */
@@ -45,10 +61,12 @@ class TimeInfo {
     /**
      * @brief Construct a new Time Info object
      *
+     * Values which do not fit their buffers are left empty.
+     *
      * @param[in] tzZone Time zone string in geographical format
      * @param[in] tzOffset Time zone offset in proleptic format
      */
-    TimeInfo(const std::string& tzZone, const std::string& tzOffset);
+    TimeInfo(const char* tzZone, const char* tzOffset);
 
     /**
      * @brief Default destructor
@@ -66,28 +84,30 @@ class TimeInfo {
      *
      * @return zone
      */
-    std::string getTzZone() const;
+    const char* getTzZone() const;
 
     /**
      * @brief Setter for zone
      *
      * @param value zone string
+     * @return False if the value is too long, the zone is left unchanged
      */
-    void setTzZone(const std::string& value);
+    bool setTzZone(const char* value);
 
     /**
      * @brief Getter for offset
      *
      * @return offset
      */
-    std::string getTzOffset() const;
+    const char* getTzOffset() const;
 
     /**
      * @brief Setter for offset
      *
      * @param value offset string
+     * @return False if the value is too long, the offset is left unchanged
      */
-    void setTzOffset(const std::string& value);
+    bool setTzOffset(const char* value);
 
     /**
      * @brief Getter for time format
@@ -103,10 +123,47 @@ class TimeInfo {
      */
     void setTimeFormat(TimeFormat value);
 
+    /**
+     * @brief Get the number of NTP servers
+     *
+     * @return number of servers
+     */
+    uint8_t getNtpServerCount() const;
+
+    /**
+     * @brief Get the host name of an NTP server
+     *
+     * @param index server index, less than getNtpServerCount()
+     * @return host name
+     */
+    const char* getNtpServer(uint8_t index) const;
+
+    /**
+     * @brief Get a copy of the NTP server list
+     *
+     * @return host names of the NTP servers
+     */
+    std::vector<std::string> getNtpServers() const;
+
+    /**
+     * @brief Remove all NTP servers
+     */
+    void clearNtpServers();
+
+    /**
+     * @brief Append an NTP server
+     *
+     * @param value host name of the NTP server
+     * @return False if the list is full or the name is too long
+     */
+    bool addNtpServer(const char* value);
+
   private:
-    std::string mTzZone;
-    std::string mTzOffset;
-    TimeFormat mTimeFormat;
+    char mTzZone[kTzZoneSize] = {};
+    char mTzOffset[kTzOffsetSize] = {};
+    TimeFormat mTimeFormat = TimeFormat::Hour24;
+    char mNtpServers[kMaxNtpServers][kNtpServerSize] = {"pool.ntp.org"};
+    uint8_t mNtpServerCount = 1;
 };
 
 #endif   // time_info_h
\ No newline at end of file
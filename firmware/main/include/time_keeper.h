@@ -0,0 +1,120 @@
+/******************************************************************************
+ * File:    time_keeper.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Declaration of a service publishing the local time once a second
+ ******************************************************************************/
+
+#ifndef time_keeper_h
+#define time_keeper_h
+
+#include <ctime>
+#include <inttypes.h>
+
+#include "esp_timer.h"
+
+#include "mutex.h"
+#include "seq_lock.h"
+#include "time_zone.h"
+
+/**
+ * @brief Immutable local time snapshot
+ */
+struct TimeSnapshot {
+    time_t utc;            ///< seconds since epoch
+    struct tm local;       ///< broken down local time
+    int32_t minuteOfDay;   ///< local hour * 60 + local minute
+};
+
+/**
+ * @brief Converts the system time to local time once per second
+ *
+ * The conversion (time() + TimeZone::toLocal()) runs in the esp_timer task
+ * right after every second boundary. It adds the UTC offset cached by the
+ * time zone until the next DST transition, the offset is computed from the
+ * parsed TZ rule only when a transition passes. The result is published
+ * through a SeqLock, so any task can read the current local time without
+ * taking a lock and without running the newlib TZ code.
+ */
+class TimeKeeper {
+  public:
+    /**
+     * @brief Callback invoked after every tick with the new snapshot
+     *
+     * Runs in the esp_timer task (or in the task calling tick()), it must
+     * not block.
+     */
+    using TickCallback = void (*)(const TimeSnapshot& snapshot, void* arg);
+
+    /**
+     * @brief Construct a new Time Keeper object
+     */
+    TimeKeeper();
+
+    /**
+     * @brief Publish the first snapshot and start the 1 s tick
+     *
+     * @param callback optional tick callback
+     * @param arg argument passed to the callback
+     * @param hasTimer false if the ticks are driven by tick() only
+     */
+    void initialize(TickCallback callback = nullptr, void* arg = nullptr,
+                    bool hasTimer = true);
+
+    /**
+     * @brief Publish the current time and run the tick callback
+     *
+     * Used to drive the ticks from an external event. Must not be called
+     * concurrently with the timer tick.
+     */
+    void tick();
+
+    /**
+     * @brief Convert and publish the current time right away
+     *
+     * Has to be called after the time zone changes or the system time is
+     * stepped. The tick is re-aligned to the new second boundary.
+     * The callback is not called.
+     */
+    void refresh();
+
+    /**
+     * @brief Set the POSIX TZ rule used for the local time
+     *
+     * Call refresh() afterwards to publish the new local time.
+     *
+     * @param posixTz rule, e.g. "CET-1CEST,M3.5.0,M10.5.0/3"
+     * @return false if the rule is not valid, UTC is used then
+     */
+    bool setTimeZone(const std::string& posixTz);
+
+    /**
+     * @brief Get the time zone used for the local time
+     *
+     * @return time zone
+     */
+    const TimeZone& getTimeZone() const;
+
+    /**
+     * @brief Get the last published snapshot
+     *
+     * Lock-free, can be called from any task.
+     *
+     * @return time snapshot
+     */
+    TimeSnapshot getSnapshot() const;
+
+  private:
+    static void timerCallback(void* param);
+    void publish();
+    void scheduleNextTick();
+
+    esp_timer_handle_t mTimer;
+    TickCallback mCallback;
+    void* mCallbackArg;
+    SeqLock<TimeSnapshot> mSnapshot;
+    TimeZone mTimeZone;
+    Mutex mWriterMutex;
+};
+
+#endif   // time_keeper_h
@@ -0,0 +1,117 @@
+/******************************************************************************
+ * File:    time_zone.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Declaration of a POSIX TZ rule with a cached UTC offset
+ ******************************************************************************/
+
+#ifndef time_zone_h
+#define time_zone_h
+
+#include <ctime>
+#include <inttypes.h>
+#include <string>
+
+#include "mutex.h"
+#include "seq_lock.h"
+
+/**
+ * @brief Day and time of a DST transition as in the POSIX TZ rule
+ */
+struct TzTransition {
+    enum class Type : uint8_t {
+        Julian,         ///< Jn, 1-365, February 29 is never counted
+        ZeroJulian,     ///< n, 0-365, February 29 is counted
+        MonthWeekDay,   ///< Mm.w.d, d-th weekday of week w of month m
+    };
+    Type type;
+    uint8_t month;      ///< 1-12
+    uint8_t week;       ///< 1-5, 5 is the last week of the month
+    uint8_t weekday;    ///< 0-6, Sunday is 0
+    uint16_t day;       ///< day of the year of the Julian types
+    int32_t time;       ///< local time of the transition in seconds
+};
+
+/**
+ * @brief Parsed POSIX TZ rule, e.g. "CET-1CEST,M3.5.0,M10.5.0/3"
+ */
+struct TzRule {
+    int32_t stdOffset;     ///< standard time minus UTC in seconds
+    int32_t dstOffset;     ///< daylight saving time minus UTC in seconds
+    bool hasDst;           ///< the rule has a daylight saving time
+    TzTransition start;    ///< start of the DST, in standard time
+    TzTransition end;      ///< end of the DST, in daylight saving time
+};
+
+/**
+ * @brief Converts UTC to local time without the libc TZ machinery
+ *
+ * The TZ string is parsed once. The UTC offset is cached together with the
+ * interval between the surrounding DST transitions, so a conversion is a
+ * compare and an add until the next transition passes. The cache is
+ * published through a SeqLock, readers in any task do not block. Only a
+ * cache miss takes the mutex to compute the new interval.
+ */
+class TimeZone {
+  public:
+    /**
+     * @brief Construct a UTC time zone
+     */
+    TimeZone();
+
+    /**
+     * @brief Parse and use a POSIX TZ rule
+     *
+     * @param posixTz rule, e.g. "CET-1CEST,M3.5.0,M10.5.0/3"
+     * @return false if the rule is not valid, UTC is used then
+     */
+    bool setRule(const std::string& posixTz);
+
+    /**
+     * @brief Get the local time minus UTC
+     *
+     * @param utc seconds since the epoch
+     * @param[out] isDst optional, set if the daylight saving time applies
+     * @return offset in seconds
+     */
+    int32_t getUtcOffset(time_t utc, bool* isDst = nullptr) const;
+
+    /**
+     * @brief Convert UTC to a broken down local time (localtime_r())
+     *
+     * @param utc seconds since the epoch
+     * @param[out] local broken down local time
+     */
+    void toLocal(time_t utc, struct tm* local) const;
+
+    /**
+     * @brief Convert a broken down local time to UTC (mktime())
+     *
+     * The fields have to be in their ranges except tm_mday, which may run
+     * over the end of the month. tm_isdst is ignored: a local time which
+     * occurs twice maps to the earlier instant, a local time which falls
+     * into a DST gap is moved forward by the gap.
+     *
+     * @param local broken down local time
+     * @return seconds since the epoch
+     */
+    time_t toUtc(const struct tm& local) const;
+
+  private:
+    struct CachedOffset {
+        time_t from;      ///< first second the offset applies to
+        time_t until;     ///< first second the offset does not apply to
+        int32_t offset;   ///< local time minus UTC in seconds
+        bool isDst;
+    };
+
+    CachedOffset lookup(time_t utc, bool isCached) const;
+    static bool parseRule(const char* posixTz, TzRule* rule);
+    static CachedOffset computeOffset(const TzRule& rule, time_t utc);
+
+    TzRule mRule;   // guarded by mWriterMutex
+    mutable SeqLock<CachedOffset> mCache;
+    mutable Mutex mWriterMutex;
+};
+
+#endif   // time_zone_h
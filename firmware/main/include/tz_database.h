@@ -0,0 +1,71 @@
+/******************************************************************************
+ * File:    tz_database.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Declaration of the embedded time zone database
+ ******************************************************************************/
+
+#ifndef tz_database_h
+#define tz_database_h
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief Read-only access to the time zone table embedded in rodata
+ *
+ * The table is compiled from flash_data/frontend/zones.json by
+ * tools/gen_zones.py during the build. Zone names are sorted and prefix
+ * compressed in blocks of 16 entries, the first name of a block is stored
+ * in full. A lookup is a binary search over the blocks followed by a scan
+ * of one block. POSIX TZ rules are returned as pointers into the table,
+ * nothing is copied or allocated.
+ */
+class TzDatabase {
+  public:
+    /**
+     * @brief Called for every matching zone
+     *
+     * @param name zone name, valid only during the call
+     * @param rule POSIX TZ rule, valid for the whole program run
+     * @param arg user argument
+     * @return false to stop the iteration
+     */
+    using ZoneCallback = bool (*)(const char* name, const char* rule,
+                                  void* arg);
+
+    /**
+     * @brief Validate the embedded table
+     *
+     * @return True if the table is valid
+     */
+    static bool initialize();
+
+    /**
+     * @brief Get the POSIX TZ rule of a zone
+     *
+     * @param zone zone name, e.g. "Europe/Prague"
+     * @return rule or nullptr if the zone is unknown
+     */
+    static const char* findRule(const std::string& zone);
+
+    /**
+     * @brief Iterate the zones starting with a prefix in sorted order
+     *
+     * @param prefix name prefix, an empty prefix matches all zones
+     * @param callback callback called for every match
+     * @param arg argument passed to the callback
+     * @return number of zones passed to the callback
+     */
+    static size_t forEachZone(const std::string& prefix, ZoneCallback callback,
+                              void* arg);
+
+    /**
+     * @brief Get the number of zones in the table
+     *
+     * @return zone count, 0 if the table is not valid
+     */
+    static size_t getZoneCount();
+};
+
+#endif   // tz_database_h
@@ -41,6 +41,12 @@ class WebServer {
     static esp_err_t handleSetSleepInfo(httpd_req_t* req);
     static esp_err_t handleGetTimeInfo(httpd_req_t* req);
     static esp_err_t handleSetTimeInfo(httpd_req_t* req);
+    static esp_err_t handleGetSyncStatus(httpd_req_t* req);
+    static esp_err_t handleGetTemperature(httpd_req_t* req);
+    static esp_err_t handleGetZones(httpd_req_t* req);
+    static esp_err_t handleGetConfig(httpd_req_t* req);
+    static esp_err_t handleSetConfig(httpd_req_t* req);
+    static esp_err_t handleGetConfigStats(httpd_req_t* req);
     static esp_err_t handleGetWifiInfo(httpd_req_t* req);
     static esp_err_t handleSetWifiInfo(httpd_req_t* req);
 
@@ -9,7 +9,7 @@
 #define wifi_info_h
 
 #include <inttypes.h>
-#include <string>
+#include <stddef.h>
 
 /**
  * @brief An enumeration representing wifi authentication types
@@ -36,9 +36,21 @@ constexpr const char* wifiAuthTypeToString(WifiAuthType waf) {
 /**
  * @brief Represents a Wifi info class
  *
+ * The strings are kept in fixed-size buffers, so the class owns no heap and
+ * copying it is a plain memory copy.
  */
 class WifiInfo {
   public:
+    /// @brief Buffer size of the hostname, including the terminator
+    static constexpr size_t kHostnameSize = 33;
+
+    /// @brief Buffer size of the SSID, including the terminator
+    static constexpr size_t kSsidSize = 33;
+
+    /// @brief Buffer size of the base64 encoded password (64 bytes at most),
+    /// including the terminator
+    static constexpr size_t kPasswordSize = 89;
+
     /**
      * @brief Default constructor
      */
@@ -47,12 +59,14 @@ class WifiInfo {
     /**
      * @brief Construct a new Wifi Info object
      *
+     * Values which do not fit their buffers are left empty.
+     *
      * @param hostname hostname
      * @param ssid SSID
      * @param password password
      */
-    WifiInfo(const std::string& hostname, const std::string& ssid,
-             const WifiAuthType& authType, const std::string& password);
+    WifiInfo(const char* hostname, const char* ssid,
+             const WifiAuthType& authType, const char* password);
 
     /**
      * @brief Default destructor
@@ -76,28 +90,30 @@ class WifiInfo {
      *
      * @return hostname
      */
-    std::string getHostname() const;
+    const char* getHostname() const;
 
     /**
      * @brief Setter for hostname
      *
      * @param value hostname
+     * @return False if the value is too long, the hostname is left unchanged
      */
-    void setHostname(const std::string& value);
+    bool setHostname(const char* value);
 
     /**
      * @brief Getter for ssid
      *
      * @return SSID
      */
-    std::string getSSID() const;
+    const char* getSSID() const;
 
     /**
      * @brief Setter for SSID
      *
      * @param value ssid
+     * @return False if the value is too long, the SSID is left unchanged
      */
-    void setSSID(const std::string& value);
+    bool setSSID(const char* value);
 
     /**
      * @brief Getter for Wifi authentication type
@@ -118,20 +134,21 @@ class WifiInfo {
      *
      * @return base64 encoded password
      */
-    std::string getPassword() const;
+    const char* getPassword() const;
 
     /**
      * @brief Setter for password
      *
      * @param value base64 encoded password
+     * @return False if the value is too long, the password is left unchanged
      */
-    void setPassword(const std::string& value);
+    bool setPassword(const char* value);
 
   private:
-    std::string mHostname;
-    std::string mSsid;
-    WifiAuthType mAuthType;
-    std::string mPassword;
+    char mHostname[kHostnameSize] = {};
+    char mSsid[kSsidSize] = {};
+    WifiAuthType mAuthType = WifiAuthType::Open;
+    char mPassword[kPasswordSize] = {};
 };
 
 #endif   // wifi_info_h
\ No newline at end of file
@@ -9,37 +9,95 @@
 
 #include <mutex>
 
-#include "driver/rmt_tx.h"
-#include "led_strip.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "soc/soc_caps.h"
 
-static constexpr uint16_t kLedCount = 1;
 static constexpr uint8_t kPulseTime = 10;
 static constexpr uint8_t kMaxBrightness = 255;
+static constexpr uint16_t kFramePeriodMs = 4;   // 512 * 4 ms = ~2 s period
+static constexpr uint32_t kRmtResolution = 10 * 1000 * 1000;   // 0.1 us
+static constexpr size_t kTransmitQueueDepth = 4;
+static constexpr int kTransmitTimeoutMs = 10;
+// a frame is out in ~80 us, the channel is released on the next call
+static constexpr uint32_t kReleaseRetryMs = 1;
 
-LedController::LedController(gpio_num_t ledPin)
-    : mLedPin(ledPin), mCounter(0), mDirection(true), mTempState(std::nullopt) {
+// WS2812 bit timings in RMT ticks
+static constexpr uint16_t kT0High = 3;    // 0.3 us
+static constexpr uint16_t kT0Low = 9;     // 0.9 us
+static constexpr uint16_t kT1High = 9;    // 0.9 us
+static constexpr uint16_t kT1Low = 3;     // 0.3 us
+static constexpr uint16_t kReset = 250;   // 2 x 25 us low
+
+// An 8-bit gamma-correction table for achieving a better looking
+// brightness perception
+// Code borrowed from:
+// https://cdn-learn.adafruit.com/downloads/pdf/led-tricks-gamma-correction.pdf
+static const uint8_t kGamma8[] = {
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,   1,
+    1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,
+    2,   2,   2,   2,   2,   3,   3,   3,   3,   3,   3,   4,   4,
+    4,   4,   5,   5,   5,   5,   5,   6,   6,   6,   6,   7,   7,
+    7,   8,   8,   8,   9,   9,   9,   10,  10,  10,  11,  11,  11,
+    12,  12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,
+    18,  18,  19,  19,  20,  20,  21,  21,  22,  22,  23,  24,  24,
+    25,  25,  26,  27,  27,  28,  29,  29,  30,  31,  31,  32,  33,
+    34,  34,  35,  36,  37,  38,  38,  39,  40,  41,  42,  42,  43,
+    44,  45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56,
+    57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  68,  69,  70,
+    71,  72,  73,  75,  76,  77,  78,  80,  81,  82,  84,  85,  86,
+    88,  89,  90,  92,  93,  94,  96,  97,  99,  100, 102, 103, 105,
+    106, 108, 109, 111, 112, 114, 115, 117, 119, 120, 122, 124, 125,
+    127, 129, 130, 132, 134, 136, 137, 139, 141, 143, 145, 146, 148,
+    150, 152, 154, 156, 158, 160, 162, 164, 166, 168, 170, 172, 174,
+    176, 178, 180, 182, 184, 186, 188, 191, 193, 195, 197, 199, 202,
+    204, 206, 209, 211, 213, 215, 218, 220, 223, 225, 227, 230, 232,
+    235, 237, 240, 242, 245, 247, 250, 252, 255};
+
+/**
+ * @brief Encode a byte into WS2812 symbols, MSB first
+ *
+ * @param value byte to encode
+ * @param symbols output array of 8 symbols
+ */
+static void encodeByte(uint8_t value, rmt_symbol_word_t* symbols) {
+    for (int bit = 0; bit < 8; ++bit) {
+        bool isOne = value & (0x80 >> bit);
+        symbols[bit].level0 = 1;
+        symbols[bit].duration0 = isOne ? kT1High : kT0High;
+        symbols[bit].level1 = 0;
+        symbols[bit].duration1 = isOne ? kT1Low : kT0Low;
+    }
 }
 
+LedController::LedController(gpio_num_t ledPin)
+    : mLedPin(ledPin), mChannel(nullptr), mEncoder(nullptr), mSymbols{},
+      mIsBufferBusy{false, false}, mIsChannelEnabled(false), mWriteIndex(0),
+      mDoneIndex(0),
+      mEffectFrames{}, mEffectFrameCount(0), mEffectIndex(0), mLastFrame{},
+      mHasLastFrame(false), mFramesRendered(0), mFramesSent(0) {}
+
 void LedController::initialize(LedInfo ledInfo) {
-    {
-        std::lock_guard<Mutex> lock(mMutex);
-        mLedInfo = ledInfo;
-    }
-    led_strip_config_t ledConfig = {};
-    ledConfig.strip_gpio_num = mLedPin;
-    ledConfig.max_leds = kLedCount;
-    ledConfig.led_model = LED_MODEL_WS2812;
-    ledConfig.color_component_format =
-        LED_STRIP_COLOR_COMPONENT_FMT_GRB;   // WS2812 uses GRB order
+    setLedInfo(ledInfo);
+    rmt_tx_channel_config_t channelConfig = {};
+    channelConfig.gpio_num = mLedPin;
+    channelConfig.clk_src = RMT_CLK_SRC_DEFAULT;
+    channelConfig.resolution_hz = kRmtResolution;
+    channelConfig.mem_block_symbols = 64;
+    channelConfig.trans_queue_depth = kTransmitQueueDepth;
+#if SOC_RMT_SUPPORT_DMA
+    channelConfig.flags.with_dma = true;
+#endif
+    ESP_ERROR_CHECK(rmt_new_tx_channel(&channelConfig, &mChannel));
 
-    led_strip_rmt_config_t rmtConfig = {};
-    rmtConfig.clk_src = RMT_CLK_SRC_DEFAULT;
-    rmtConfig.resolution_hz = 10 * 1000 * 1000;
+    rmt_copy_encoder_config_t encoderConfig = {};
+    ESP_ERROR_CHECK(rmt_new_copy_encoder(&encoderConfig, &mEncoder));
 
+    rmt_tx_event_callbacks_t callbacks = {};
+    callbacks.on_trans_done = onTransmitDone;
     ESP_ERROR_CHECK(
-        led_strip_new_rmt_device(&ledConfig, &rmtConfig, &mLedHandle));
-
-    test();
+        rmt_tx_register_event_callbacks(mChannel, &callbacks, this));
 }
 
 void LedController::test() {
@@ -67,114 +125,183 @@ void LedController::test() {
             uint8_t g = gFrom + ((gTo - gFrom) * step) / steps;
             uint8_t b = bFrom + ((bTo - bFrom) * step) / steps;
 
-            led_strip_set_pixel(mLedHandle, 0, r, g, b);
-            led_strip_refresh(mLedHandle);
+            sendFrame(r, g, b);
             vTaskDelay(pdMS_TO_TICKS(delayMs));
         }
     }
 }
 
-void LedController::update() {
-    if (mDirection) {
-        if (mCounter < kMaxBrightness) {
-            mCounter++;
-        } else {
-            mDirection = false;
+uint32_t LedController::update() {
+    // First check if there is a temporal state set, if not use the base state
+    LedStates states = mStates.load();
+    LedInfo currentLedInfo = states.hasTemporal ? states.temporal : states.base;
+    switch (currentLedInfo.getState()) {
+    case LedState::On:
+        sendFrame(currentLedInfo.getRed(), currentLedInfo.getGreen(),
+                  currentLedInfo.getBlue());
+        return releaseChannel() ? 0 : kReleaseRetryMs;
+    case LedState::Fade:
+    case LedState::Pulse: {
+        if (mEffectFrameCount == 0 ||
+            currentLedInfo.getState() != mEffectInfo.getState() ||
+            currentLedInfo.getRed() != mEffectInfo.getRed() ||
+            currentLedInfo.getGreen() != mEffectInfo.getGreen() ||
+            currentLedInfo.getBlue() != mEffectInfo.getBlue()) {
+            buildEffect(currentLedInfo);
         }
-    } else {
-        if (mCounter == 0) {
-            mDirection = true;
+        const EffectFrame& frame = mEffectFrames[mEffectIndex];
+        sendFrame(frame.red, frame.green, frame.blue);
+        mEffectIndex = (mEffectIndex + 1) % mEffectFrameCount;
+        return frame.holdMs;
+    }
+    case LedState::Off:
+    default:
+        sendFrame(0, 0, 0);
+        return releaseChannel() ? 0 : kReleaseRetryMs;
+    }
+}
+
+void LedController::buildEffect(const LedInfo& ledInfo) {
+    mEffectInfo = ledInfo;
+    mEffectFrameCount = 0;
+    mEffectIndex = 0;
+
+    // Brightness runs 1..255, holds 255, runs 254..0 and holds 0
+    uint8_t counter = 0;
+    bool direction = true;
+    for (size_t step = 0; step < kEffectSteps; ++step) {
+        if (direction) {
+            if (counter < kMaxBrightness) {
+                counter++;
+            } else {
+                direction = false;
+            }
         } else {
-            mCounter--;
+            if (counter == 0) {
+                direction = true;
+            } else {
+                counter--;
+            }
+        }
+
+        EffectFrame frame = {};
+        if (ledInfo.getState() == LedState::Fade) {
+            frame.red = (ledInfo.getRed() * kGamma8[counter]) / kMaxBrightness;
+            frame.green =
+                (ledInfo.getGreen() * kGamma8[counter]) / kMaxBrightness;
+            frame.blue =
+                (ledInfo.getBlue() * kGamma8[counter]) / kMaxBrightness;
+        } else if (counter < kPulseTime ||
+                   counter >= kMaxBrightness - kPulseTime) {
+            frame.red = ledInfo.getRed();
+            frame.green = ledInfo.getGreen();
+            frame.blue = ledInfo.getBlue();
+        }
+
+        // Consecutive equal steps are merged into one frame
+        if (mEffectFrameCount > 0) {
+            EffectFrame& last = mEffectFrames[mEffectFrameCount - 1];
+            if (last.red == frame.red && last.green == frame.green &&
+                last.blue == frame.blue) {
+                last.holdMs += kFramePeriodMs;
+                continue;
+            }
         }
+        frame.holdMs = kFramePeriodMs;
+        mEffectFrames[mEffectFrameCount++] = frame;
     }
+}
 
-    // First check if there is a temporal state set, if not use the state from
-    // member LedInfo object
-    std::lock_guard<Mutex> lock(mMutex);
-    LedInfo currentLedInfo = mTempState.value_or(mLedInfo);
-    switch (currentLedInfo.getState()) {
-    case LedState::Off: {
-        ESP_ERROR_CHECK(led_strip_clear(mLedHandle));
-        ESP_ERROR_CHECK(led_strip_refresh(mLedHandle));
-        break;
+void LedController::sendFrame(uint8_t r, uint8_t g, uint8_t b) {
+    mFramesRendered.fetch_add(1, std::memory_order_relaxed);
+    if (mHasLastFrame && mLastFrame[0] == r && mLastFrame[1] == g &&
+        mLastFrame[2] == b) {
+        return;
     }
-    case LedState::On: {
-        ESP_ERROR_CHECK(led_strip_set_pixel(
-            mLedHandle, 0, currentLedInfo.getRed(), currentLedInfo.getGreen(),
-            currentLedInfo.getBlue()));
-        ESP_ERROR_CHECK(led_strip_refresh(mLedHandle));
-        break;
+    // Both buffers are in flight only if frames come faster than they are
+    // sent (~80 us), so waiting here is short and practically never happens
+    if (mIsBufferBusy[mWriteIndex]) {
+        ESP_ERROR_CHECK(rmt_tx_wait_all_done(mChannel, kTransmitTimeoutMs));
     }
-    case LedState::Fade: {
-        // An 8-bit gamma-correction table for achieving a better looking
-        // brightness perception
-        // Code borrowed from:
-        // https://cdn-learn.adafruit.com/downloads/pdf/led-tricks-gamma-correction.pdf
-        const uint8_t gamma8[] = {
-            0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
-            0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,   1,
-            1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,
-            2,   2,   2,   2,   2,   3,   3,   3,   3,   3,   3,   4,   4,
-            4,   4,   5,   5,   5,   5,   5,   6,   6,   6,   6,   7,   7,
-            7,   8,   8,   8,   9,   9,   9,   10,  10,  10,  11,  11,  11,
-            12,  12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,
-            18,  18,  19,  19,  20,  20,  21,  21,  22,  22,  23,  24,  24,
-            25,  25,  26,  27,  27,  28,  29,  29,  30,  31,  31,  32,  33,
-            34,  34,  35,  36,  37,  38,  38,  39,  40,  41,  42,  42,  43,
-            44,  45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56,
-            57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  68,  69,  70,
-            71,  72,  73,  75,  76,  77,  78,  80,  81,  82,  84,  85,  86,
-            88,  89,  90,  92,  93,  94,  96,  97,  99,  100, 102, 103, 105,
-            106, 108, 109, 111, 112, 114, 115, 117, 119, 120, 122, 124, 125,
-            127, 129, 130, 132, 134, 136, 137, 139, 141, 143, 145, 146, 148,
-            150, 152, 154, 156, 158, 160, 162, 164, 166, 168, 170, 172, 174,
-            176, 178, 180, 182, 184, 186, 188, 191, 193, 195, 197, 199, 202,
-            204, 206, 209, 211, 213, 215, 218, 220, 223, 225, 227, 230, 232,
-            235, 237, 240, 242, 245, 247, 250, 252, 255};
-
-        ESP_ERROR_CHECK(led_strip_set_pixel(
-            mLedHandle, 0,
-            (currentLedInfo.getRed() * gamma8[mCounter]) / kMaxBrightness,
-            (currentLedInfo.getGreen() * gamma8[mCounter]) / kMaxBrightness,
-            (currentLedInfo.getBlue() * gamma8[mCounter]) / kMaxBrightness));
-        ESP_ERROR_CHECK(led_strip_refresh(mLedHandle));
-
-        break;
+    rmt_symbol_word_t* symbols = mSymbols[mWriteIndex];
+    // WS2812 uses GRB order
+    encodeByte(g, &symbols[0]);
+    encodeByte(r, &symbols[8]);
+    encodeByte(b, &symbols[16]);
+    symbols[24].level0 = 0;
+    symbols[24].duration0 = kReset;
+    symbols[24].level1 = 0;
+    symbols[24].duration1 = kReset;
+
+    if (!mIsChannelEnabled) {
+        ESP_ERROR_CHECK(rmt_enable(mChannel));
+        mIsChannelEnabled = true;
     }
-    case LedState::Pulse: {
-        if (mCounter < kPulseTime || mCounter >= kMaxBrightness - kPulseTime) {
-            ESP_ERROR_CHECK(led_strip_set_pixel(
-                mLedHandle, 0, currentLedInfo.getRed(),
-                currentLedInfo.getGreen(), currentLedInfo.getBlue()));
-        } else {
-            ESP_ERROR_CHECK(led_strip_clear(mLedHandle));
+    rmt_transmit_config_t transmitConfig = {};
+    mIsBufferBusy[mWriteIndex] = true;
+    ESP_ERROR_CHECK(rmt_transmit(mChannel, mEncoder, symbols,
+                                 sizeof(mSymbols[0]), &transmitConfig));
+    mWriteIndex ^= 1;
+
+    mLastFrame[0] = r;
+    mLastFrame[1] = g;
+    mLastFrame[2] = b;
+    mHasLastFrame = true;
+    mFramesSent.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool LedController::releaseChannel() {
+    // The enabled channel holds a power management lock, a static color
+    // does not need it once the frame is out. WS2812 keeps the last color.
+    // rmt_disable() would abort a frame in flight and must not be called
+    // from the transmit done callback, so the release is retried instead.
+    if (mIsChannelEnabled) {
+        if (mIsBufferBusy[0] || mIsBufferBusy[1]) {
+            return false;
         }
-        ESP_ERROR_CHECK(led_strip_refresh(mLedHandle));
-        break;
-    }
-    default:
-        break;
+        ESP_ERROR_CHECK(rmt_disable(mChannel));
+        mIsChannelEnabled = false;
     }
+    return true;
 }
 
-void LedController::setLedInfo(const LedInfo& ledInfo) {
-    std::lock_guard<Mutex> lock(mMutex);
-    mLedInfo = ledInfo;
+bool LedController::onTransmitDone(rmt_channel_handle_t channel,
+                                   const rmt_tx_done_event_data_t* edata,
+                                   void* param) {
+    (void) channel;
+    (void) edata;
+    // Transactions finish in the order they were queued
+    LedController* self = static_cast<LedController*>(param);
+    self->mIsBufferBusy[self->mDoneIndex] = false;
+    self->mDoneIndex ^= 1;
+    return false;
 }
 
-LedInfo LedController::getLedInfo() {
-    std::lock_guard<Mutex> lock(mMutex);
-    auto ledInfo = mLedInfo;
-    return ledInfo;
+LedFrameStats LedController::getFrameStats() const {
+    return {mFramesRendered.load(std::memory_order_relaxed),
+            mFramesSent.load(std::memory_order_relaxed)};
 }
 
+void LedController::setLedInfo(const LedInfo& ledInfo) {
+    std::lock_guard<Mutex> lock(mWriterMutex);
+    LedStates states = mStates.load();
+    states.base = ledInfo;
+    mStates.store(states);
+}
+
+LedInfo LedController::getLedInfo() { return mStates.load().base; }
+
 void LedController::setTemporalState(const LedInfo& state) {
-    std::lock_guard<Mutex> lock(mMutex);
-    mTempState = state;
+    std::lock_guard<Mutex> lock(mWriterMutex);
+    LedStates states = mStates.load();
+    states.temporal = state;
+    states.hasTemporal = true;
+    mStates.store(states);
 }
 
 void LedController::clearTemporalState() {
-    std::lock_guard<Mutex> lock(mMutex);
-    mTempState.reset();
+    std::lock_guard<Mutex> lock(mWriterMutex);
+    LedStates states = mStates.load();
+    states.hasTemporal = false;
+    mStates.store(states);
 }
\ No newline at end of file
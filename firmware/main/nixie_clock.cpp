@@ -7,14 +7,16 @@
 
 #include "nixie_clock.h"
 
+#include <algorithm>
 #include <cstring>
 #include <mutex>
+#include <sys/time.h>
 
 #include "cJSON.h"
 #include "dns_server.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
-#include "esp_sntp.h"
+#include "esp_pm.h"
 #include "esp_system.h"   //esp_init funtions esp_err_t
 #include "esp_wifi.h"     //esp_wifi_init functions and wifi operations
 #include "freertos/FreeRTOS.h"
@@ -22,7 +24,10 @@
 #include "lwip/inet.h"
 #include "mdns.h"
 
+#include "civil_time.h"
+#include "config_bus.h"
 #include "config_store.h"
+#include "tz_database.h"
 #include "wifi_info.h"
 
 #define WIFI_CONNECTED_BIT BIT0
@@ -39,27 +44,79 @@ static constexpr gpio_num_t kBcdPinD = GPIO_NUM_16;
 static constexpr i2c_port_t kI2cPort = I2C_NUM_0;
 static constexpr gpio_num_t kI2cSda = GPIO_NUM_22;
 static constexpr gpio_num_t kI2cScl = GPIO_NUM_23;
-static constexpr u_int32_t kLedControllerUpdatePeriod = 4;   // ms 255* 4 = ~1s
-static constexpr u_int32_t kTimeUpdatePeriod = 60000;        // 1 minute
-static constexpr u_int32_t kDigitDuration = 300;
-static constexpr u_int32_t kShowTimeDelay = 750;
-static constexpr u_int32_t kPauseDuration = 2000;
-static constexpr u_int32_t kIntroDigitPeriod = 50;
-static constexpr u_int8_t kCurrentTimeRepeatTimes = 3;
-static const char* kNtpServerAddr = "pool.ntp.org";
-static constexpr uint32_t kNtpSyncInterval = 3600000;   // 1 hour
-
-static Ds3231* gRtcPtr = nullptr;
+static constexpr gpio_num_t kRtcSqwPin = GPIO_NUM_21;
+static constexpr int32_t kMinutesPerDay = 24 * 60;
+static constexpr int64_t kSleepTransitionGuardUs = 2000;
+static constexpr int kMinCpuFreqMhz = 40;   // XTAL frequency
+// A system clock closer than this to the next minute is behind the RTC
+// minute alarm, a farther one has already passed the minute
+static constexpr int64_t kMaxAlarmLeadUs = 30 * 1000000LL;
+
+// Events the loop task is waiting for (task notification bits)
+static constexpr uint32_t kMinuteTickEvent = BIT0;
+static constexpr uint32_t kLedFrameEvent = BIT1;
+static constexpr uint32_t kTimeChangedEvent = BIT2;
+static constexpr uint32_t kSleepTransitionEvent = BIT3;
+static constexpr uint32_t kTimeSyncedEvent = BIT4;
+static constexpr uint32_t kTemperatureEvent = BIT5;
+static constexpr uint32_t kMinuteAlarmEvent = BIT6;
+
+
+/**
+ * @brief Check whether a minute of the day falls into the sleep window
+ */
+static bool isInSleepWindow(const SleepInfo& sleepInfo, int32_t minuteOfDay) {
+    if (sleepInfo.getSleepBefore() < sleepInfo.getSleepAfter()) {
+        return minuteOfDay < sleepInfo.getSleepBefore() ||
+               minuteOfDay > sleepInfo.getSleepAfter();
+    }
+    return minuteOfDay < sleepInfo.getSleepBefore() &&
+           minuteOfDay > sleepInfo.getSleepAfter();
+}
+
+/**
+ * @brief Find the next instant, strictly after now, at which the local time
+ * reads the given minute of the day.
+ *
+ * The time zone applies the DST rules, so DST shifts are accounted for.
+ */
+static time_t nextLocalMinute(const TimeZone& timeZone, int32_t minuteOfDay,
+                              time_t now) {
+    for (int dayOffset = 0; dayOffset < 2; ++dayOffset) {
+        struct tm t;
+        timeZone.toLocal(now, &t);
+        t.tm_mday += dayOffset;
+        t.tm_hour = minuteOfDay / 60;
+        t.tm_min = minuteOfDay % 60;
+        t.tm_sec = 0;
+        time_t candidate = timeZone.toUtc(t);
+        if (candidate > now) {
+            return candidate;
+        }
+    }
+    // Unreachable unless the TZ rules are broken, retry in a day
+    return now + kMinutesPerDay * 60;
+}
 
 NixieClock::NixieClock()
     : mLedController(kLedPin),
-      mNixieTube(kBcdPinA, kBcdPinB, kBcdPinC, kBcdPinD), mWebServer(*this),
-      mShowCurrentTimeTaskHandle(nullptr), mI2c(kI2cPort, kI2cSda, kI2cScl),
-      mRtc(mI2c), mLastSleepModeStatus(false) {
-    gRtcPtr = &mRtc;
+      mNixieTube(kBcdPinA, kBcdPinB, kBcdPinC, kBcdPinD),
+      mDisplayWorker(mNixieTube, *this), mWebServer(*this),
+      mLoopTaskHandle(nullptr),
+      mLastMinuteOfDay(-1), mLedTimer(nullptr), mSleepTimer(nullptr),
+      mTemperatureTimer(nullptr), mLoopWakeups(0),
+      mI2c(kI2cPort, kI2cSda, kI2cScl), mRtc(mI2c),
+      mRtcCalibrator(mRtc), mClockDiscipline(mRtc, mRtcCalibrator),
+      mLastSleepModeStatus(false), mIsLedReady(false), mIsTimeValid(false),
+      mIsFirstDigitShown(false), mDisplayPmLock("display"),
+      mLedPmLock("led"), mBootStartUs(0) {
 }
 
 void NixieClock::initialize() {
+    // The boot is staged: the time from the RTC is shown as soon as the tube
+    // is up, the LED test and the network are started in the background
+    mBootStartUs = esp_timer_get_time();
+
     ESP_LOGI(kTag, "Initialize I2C interface...");
     mI2c.initialize();
     ESP_LOGI(kTag, "Initialize I2C interface... done");
@@ -70,23 +127,118 @@ void NixieClock::initialize() {
 
     ESP_LOGI(kTag, "Initialize Nixie tube...");
     mNixieTube.initialize();
+    mDisplayWorker.initialize();
     ESP_LOGI(kTag, "Initialize Nixie tube... done");
 
     ESP_LOGI(kTag, "Initialize Config store...");
     ConfigStore::initialize();
     ESP_LOGI(kTag, "Initialize Config store... done");
 
+    ESP_LOGI(kTag, "Initialize RTC calibration...");
+    mRtcCalibrator.initialize();
+    ESP_LOGI(kTag, "Initialize RTC calibration... done");
+
+    mSleepInfo = ConfigStore::loadSleepInfo().value_or(SleepInfo());
+
+    ESP_LOGI(kTag, "Setting up time zone...");
+    TzDatabase::initialize();
+    mTimeInfo = ConfigStore::loadTimeInfo().value_or(TimeInfo());
+    // The rules of a zone may have changed with a firmware update
+    const char* tzRule = TzDatabase::findRule(mTimeInfo.getTzZone());
+    if (tzRule != nullptr && strcmp(mTimeInfo.getTzOffset(), tzRule) != 0) {
+        mTimeInfo.setTzOffset(tzRule);
+        ConfigStore::saveTimeInfo(mTimeInfo);
+    }
+    ESP_LOGI(kTag, "Time zone: %s", mTimeInfo.getTzOffset());
+    mTimeKeeper.setTimeZone(mTimeInfo.getTzOffset());
+    ESP_LOGI(kTag, "Setting up time zone... done");
+
+    // The RTC time is used until NTP refines it
+    mIsTimeValid = setSystemTimeFromRtc();
+
     ESP_LOGI(kTag, "Initialize Led controller...");
-    mLedController.initialize(ConfigStore::loadLedInfo().value_or(LedInfo()));
+    mLedInfo = ConfigStore::loadLedInfo().value_or(LedInfo());
+    mLedController.initialize(mLedInfo);
     ESP_LOGI(kTag, "Initialize Led controller... done");
 
+    esp_timer_create_args_t ledTimerArgs = {};
+    ledTimerArgs.callback = ledTimerCallback;
+    ledTimerArgs.arg = this;
+    ledTimerArgs.dispatch_method = ESP_TIMER_TASK;
+    ledTimerArgs.name = "ledTimer";
+    ESP_ERROR_CHECK(esp_timer_create(&ledTimerArgs, &mLedTimer));
+
+    esp_timer_create_args_t sleepTimerArgs = {};
+    sleepTimerArgs.callback = sleepTimerCallback;
+    sleepTimerArgs.arg = this;
+    sleepTimerArgs.dispatch_method = ESP_TIMER_TASK;
+    sleepTimerArgs.name = "sleepTimer";
+    ESP_ERROR_CHECK(esp_timer_create(&sleepTimerArgs, &mSleepTimer));
+
+    // The temperature is sampled on the RTC conversion cadence, apart from
+    // the time reads
+    mRtc.sampleTemperature();
+    esp_timer_create_args_t temperatureTimerArgs = {};
+    temperatureTimerArgs.callback = temperatureTimerCallback;
+    temperatureTimerArgs.arg = this;
+    temperatureTimerArgs.dispatch_method = ESP_TIMER_TASK;
+    temperatureTimerArgs.name = "temperatureTimer";
+    ESP_ERROR_CHECK(
+        esp_timer_create(&temperatureTimerArgs, &mTemperatureTimer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(
+        mTemperatureTimer, Ds3231::kTemperatureInterval * 1000000ULL));
+
+    xTaskCreate(loopTask, "loopTask", 4096, this, 2, &mLoopTaskHandle);
+
+    // In the low power mode the RTC alarm drives the minute logic and the
+    // chip sleeps in between, otherwise the 1 Hz square wave disciplines the
+    // system clock every second
+    bool isLowPower = enableLowPowerMode();
+    if (!isLowPower) {
+        mClockDiscipline.initialize(kRtcSqwPin);
+    }
+    mTimeKeeper.initialize(timeTickCallback, this, !isLowPower);
+
+    handleSleepMode();
+    scheduleSleepTransition();
+
+    if (mIsTimeValid && !isInSleepMode()) {
+        showCurrentTime();
+    }
+
+    // From now on the changes are pushed by the config store
+    ConfigBus::subscribe<LedInfo>(ledInfoCallback, this);
+    ConfigBus::subscribe<SleepInfo>(sleepInfoCallback, this);
+    ConfigBus::subscribe<TimeInfo>(timeInfoCallback, this);
+    ConfigBus::subscribe<WifiInfo>(wifiInfoCallback, this);
+
+    xTaskCreate(bootTask, "bootTask", 4096, this, 1, nullptr);
+}
+
+void NixieClock::bootTask(void* param) {
+    NixieClock* self = static_cast<NixieClock*>(param);
+
+    ESP_LOGI(kTag, "Led controller test...");
+    self->mLedController.test();
+    self->mIsLedReady = true;
+    self->requestLedUpdate();
+    ESP_LOGI(kTag, "Led controller test... done");
+
+    self->startNetwork();
+
+    ESP_LOGI(kTag, "Background boot finished after %lld ms",
+             (esp_timer_get_time() - self->mBootStartUs) / 1000);
+    vTaskDelete(nullptr);
+}
+
+void NixieClock::startNetwork() {
     WifiInfo wifiInfo = ConfigStore::loadWifiInfo().value_or(WifiInfo());
 
     ESP_LOGI(kTag, "Initialize Wifi...");
     mWifiManager.initialize();
     ESP_LOGI(kTag, "Initialize Wifi... done");
 
-    if (wifiInfo.getSSID() == "" || !mWifiManager.connectSta(wifiInfo)) {
+    if (wifiInfo.getSSID()[0] == '\0' || !mWifiManager.connectSta(wifiInfo)) {
         WifiInfo apWifiInfo(kApHostname, kApSsid, WifiAuthType::Open, "");
         mWifiManager.startAp(apWifiInfo);
         ESP_LOGI(kTag, "Setup captive portal...");
@@ -108,68 +260,36 @@ void NixieClock::initialize() {
     mWebServer.initialize();
     ESP_LOGI(kTag, "Initialize Web server... done");
 
-    mSleepInfo = ConfigStore::loadSleepInfo().value_or(SleepInfo());
-
-    ESP_LOGI(kTag, "Setting up time zone...");
-    mTimeInfo = ConfigStore::loadTimeInfo().value_or(TimeInfo());
-    ESP_LOGI(kTag, "Time zone: %s", mTimeInfo.getTzOffset().c_str());
-    setenv("TZ", mTimeInfo.getTzOffset().c_str(), 1);
-    tzset();
-    ESP_LOGI(kTag, "Setting up time zone... done");
-
-    bool isTimeSynced = false;
-
     // Initialize NTP only if the device is connected to some external wifi
-    // network
+    // network, the time is refined by the sync notification callback
     if (mWifiManager.getMode() == WifiManager::Mode::Sta) {
         ESP_LOGI(kTag, "Initialize SNTP...");
         initializeSNTP();
         ESP_LOGI(kTag, "Initialize SNTP... done");
-
-        ESP_LOGI(kTag, "Synchronizing time with NTP server...");
-        int retry = 0;
-        const int retry_count = 10;
-        while (++retry < retry_count) {
-            if (sntp_get_sync_status() == SNTP_SYNC_STATUS_COMPLETED) {
-                isTimeSynced = true;
-                break;
-            }
-            ESP_LOGI(kTag, "Waiting for system time to be set... (%d/%d)",
-                     retry, retry_count);
-            vTaskDelay(2000 / portTICK_PERIOD_MS);
-        }
-        ESP_LOGI(kTag, "Synchronizing time with NTP server... %s",
-                 isTimeSynced ? "Done" : "Failed");
     }
+}
 
-    // If time is not synced with SNTP, try to sync time with RTC
-    if (!isTimeSynced) {
-        struct tm rtcTimeTm;
-        if (mRtc.getTime(&rtcTimeTm)) {
-            time_t rtcTime = timegmRtc(&rtcTimeTm);
-            struct timeval tv = {.tv_sec = rtcTime, .tv_usec = 0};
-            if (settimeofday(&tv, nullptr) == 0) {
-                ESP_LOGI(kTag,
-                         "System time set from RTC: %04d-%02d-%02d "
-                         "%02d:%02d:%02d UTC",
-                         rtcTimeTm.tm_year + 1900, rtcTimeTm.tm_mon + 1,
-                         rtcTimeTm.tm_mday, rtcTimeTm.tm_hour, rtcTimeTm.tm_min,
-                         rtcTimeTm.tm_sec);
-                isTimeSynced = true;
-            } else {
-                ESP_LOGE(kTag, "Failed to set system time from RTC");
-            }
-        }
+bool NixieClock::setSystemTimeFromRtc() {
+    struct tm rtcTimeTm;
+    if (!mRtc.getTime(&rtcTimeTm)) {
+        ESP_LOGE(kTag, "Failed to read time from RTC");
+        return false;
     }
-
-    handleSleepMode();
-
-    // Show current time after the current time is synced
-    if (isTimeSynced && !isInSleepMode()) {
-        startShowCurrentTimeTask();
+    if (mRtc.hasOscillatorStopped()) {
+        ESP_LOGW(kTag, "RTC oscillator has stopped, time is not valid");
+        return false;
     }
-
-    xTaskCreate(loopTask, "loopTask", 4096, this, 2, nullptr);
+    time_t rtcTime = timegmUtc(rtcTimeTm);
+    struct timeval tv = {.tv_sec = rtcTime, .tv_usec = 0};
+    if (settimeofday(&tv, nullptr) != 0) {
+        ESP_LOGE(kTag, "Failed to set system time from RTC");
+        return false;
+    }
+    ESP_LOGI(kTag,
+             "System time set from RTC: %04d-%02d-%02d %02d:%02d:%02d UTC",
+             rtcTimeTm.tm_year + 1900, rtcTimeTm.tm_mon + 1, rtcTimeTm.tm_mday,
+             rtcTimeTm.tm_hour, rtcTimeTm.tm_min, rtcTimeTm.tm_sec);
+    return true;
 }
 
 std::optional<LedInfo> NixieClock::onGetLedInfo() const {
@@ -177,9 +297,6 @@ std::optional<LedInfo> NixieClock::onGetLedInfo() const {
 }
 
 void NixieClock::onSetLedInfo(const LedInfo& ledInfo) {
-    if (!isInSleepMode()) {
-        mLedController.setLedInfo(ledInfo);
-    }
     ConfigStore::saveLedInfo(ledInfo);
 }
 
@@ -188,12 +305,7 @@ std::optional<SleepInfo> NixieClock::onGetSleepInfo() const {
 }
 
 void NixieClock::onSetSleepInfo(const SleepInfo& sleepInfo) {
-    {
-        std::lock_guard<Mutex> lock(mMutex);
-        mSleepInfo = sleepInfo;
-    }
     ConfigStore::saveSleepInfo(sleepInfo);
-    handleSleepMode();
 }
 
 std::optional<WifiInfo> NixieClock::onGetWifiInfo() const {
@@ -202,7 +314,6 @@ std::optional<WifiInfo> NixieClock::onGetWifiInfo() const {
 
 void NixieClock::onSetWifiInfo(const WifiInfo& wifiInfo) {
     ConfigStore::saveWifiInfo(wifiInfo);
-    esp_restart();
 }
 
 std::optional<TimeInfo> NixieClock::onGetTimeInfo() const {
@@ -210,19 +321,76 @@ std::optional<TimeInfo> NixieClock::onGetTimeInfo() const {
 }
 
 void NixieClock::onSetTimeInfo(const TimeInfo& timeInfo) {
+    ConfigStore::saveTimeInfo(timeInfo);
+}
+
+DeviceConfig NixieClock::onGetConfig() const {
+    DeviceConfig config;
+    config.ledInfo = ConfigStore::loadLedInfo();
+    config.sleepInfo = ConfigStore::loadSleepInfo();
+    config.timeInfo = ConfigStore::loadTimeInfo();
+    config.wifiInfo = ConfigStore::loadWifiInfo();
+    return config;
+}
+
+void NixieClock::onSetConfig(const DeviceConfig& config) {
+    ConfigStore::saveConfig(config);
+}
+
+void NixieClock::ledInfoCallback(const LedInfo& ledInfo, void* param) {
+    NixieClock* self = static_cast<NixieClock*>(param);
+    std::lock_guard<Mutex> lock(self->mMutex);
+    self->mLedInfo = ledInfo;
+    // in the sleep mode the new color is applied on the sleep exit
+    if (!self->isInSleepMode()) {
+        self->mLedController.setLedInfo(ledInfo);
+        self->requestLedUpdate();
+    }
+}
+
+void NixieClock::sleepInfoCallback(const SleepInfo& sleepInfo, void* param) {
+    NixieClock* self = static_cast<NixieClock*>(param);
     {
-        std::lock_guard<Mutex> lock(mMutex);
-        mTimeInfo = timeInfo;
+        std::lock_guard<Mutex> lock(self->mMutex);
+        self->mSleepInfo = sleepInfo;
     }
-    ConfigStore::saveTimeInfo(timeInfo);
-    setenv("TZ", timeInfo.getTzOffset().c_str(), 1);
-    tzset();
-    LedInfo ledInfo = ConfigStore::loadLedInfo().value();
-    if (isInSleepMode()) {
-        // turn off the led
-        ledInfo.setState(LedState::Off);
+    xTaskNotify(self->mLoopTaskHandle, kSleepTransitionEvent, eSetBits);
+}
+
+void NixieClock::wifiInfoCallback(const WifiInfo& wifiInfo, void* param) {
+    // The network is reconfigured by a restart. The flush task would not get
+    // to write the new config before it.
+    ConfigStore::flush();
+    esp_restart();
+}
+
+void NixieClock::timeInfoCallback(const TimeInfo& timeInfo, void* param) {
+    NixieClock* self = static_cast<NixieClock*>(param);
+    {
+        std::lock_guard<Mutex> lock(self->mMutex);
+        self->mTimeInfo = timeInfo;
     }
-    mLedController.setLedInfo(ledInfo);
+    self->mSntpManager.setServers(timeInfo.getNtpServers());
+    self->mTimeKeeper.setTimeZone(timeInfo.getTzOffset());
+    // The local time changed, the loop task re-evaluates the sleep mode and
+    // the next sleep transition
+    xTaskNotify(self->mLoopTaskHandle, kTimeChangedEvent, eSetBits);
+}
+
+SyncStatus NixieClock::onGetSyncStatus() const {
+    SyncStatus status = mSntpManager.getStatus();
+    CalibrationInfo calibrationInfo = mRtcCalibrator.getCalibrationInfo();
+    status.rtcDriftPpb = calibrationInfo.getDriftPpb();
+    status.rtcAgingOffset = calibrationInfo.getAgingOffset();
+    return status;
+}
+
+TemperatureStats NixieClock::onGetTemperatureStats(size_t points) const {
+    return mRtc.getTemperatureStats(points);
+}
+
+ConfigStoreStats NixieClock::onGetConfigStoreStats() const {
+    return ConfigStore::getStats();
 }
 
 void NixieClock::setupCaptivePortal() {
@@ -254,149 +422,256 @@ void NixieClock::setupCaptivePortal() {
 
 void NixieClock::startMdnsService(const WifiInfo& wifiInfo) {
     ESP_ERROR_CHECK(mdns_init());
-    ESP_ERROR_CHECK(mdns_hostname_set(wifiInfo.getHostname().c_str()));
+    ESP_ERROR_CHECK(mdns_hostname_set(wifiInfo.getHostname()));
     ESP_ERROR_CHECK(mdns_instance_name_set("NixieClock web server"));
-    ESP_LOGI(kTag, "mDNS started: http://%s.local",
-             wifiInfo.getHostname().c_str());
+    ESP_LOGI(kTag, "mDNS started: http://%s.local", wifiInfo.getHostname());
 }
 
 void NixieClock::initializeSNTP() {
-    esp_sntp_setoperatingmode(SNTP_OPMODE_POLL);
-    esp_sntp_setservername(0, kNtpServerAddr);
-    esp_sntp_set_sync_interval(kNtpSyncInterval);
-    esp_sntp_set_time_sync_notification_cb(timeSyncNotificationCallback);
-    esp_sntp_init();
+    std::vector<std::string> ntpServers;
+    {
+        std::lock_guard<Mutex> lock(mMutex);
+        ntpServers = mTimeInfo.getNtpServers();
+    }
+    mSntpManager.setMaxSyncInterval(mRtcCalibrator.getSyncInterval());
+    mSntpManager.initialize(ntpServers, timeSyncCallback, this);
 }
 
-void NixieClock::timeSyncNotificationCallback(struct timeval* tv) {
-    if (!gRtcPtr) {
-        return;
-    }
-    time_t now = tv->tv_sec;
-    struct tm utcTime;
-    gmtime_r(&now, &utcTime);
-    ESP_LOGI(kTag, "Set time received from NTP to RTC");
-    gRtcPtr->setTime(&utcTime);
-}
-
-bool NixieClock::isInSleepMode() {
-    time_t now;
-    struct tm t;
-    time(&now);
-    localtime_r(&now, &t);
-    int32_t timeInMinutes = t.tm_hour * 60 + t.tm_min;
-    std::lock_guard<Mutex> lock(mMutex);
-    if (mSleepInfo.getSleepBefore() < mSleepInfo.getSleepAfter()) {
-        if (timeInMinutes < mSleepInfo.getSleepBefore() ||
-            timeInMinutes > mSleepInfo.getSleepAfter()) {
-            return true;
-        }
-    } else {
-        if (timeInMinutes < mSleepInfo.getSleepBefore() &&
-            timeInMinutes > mSleepInfo.getSleepAfter()) {
-            return true;
-        }
-    }
-    return false;
+void NixieClock::timeSyncCallback(void* param) {
+    NixieClock* self = static_cast<NixieClock*>(param);
+    // Feeds the RTC calibrator with the new offset first, a calmer RTC then
+    // allows polling NTP less often
+    self->mClockDiscipline.onNtpSync();
+    self->mSntpManager.setMaxSyncInterval(
+        self->mRtcCalibrator.getSyncInterval());
+    // The wall clock may have been stepped, refresh the local time
+    xTaskNotify(self->mLoopTaskHandle, kTimeChangedEvent | kTimeSyncedEvent,
+                eSetBits);
 }
 
+bool NixieClock::isInSleepMode() { return mLastSleepModeStatus; }
+
 void NixieClock::loopTask(void* param) {
     NixieClock* self = static_cast<NixieClock*>(param);
-    TickType_t lastWakeTime = xTaskGetTickCount();
-    const TickType_t period = pdMS_TO_TICKS(1);   // 1 ms tick
-    uint32_t msCounter = 0;
-    int32_t lastSecond = -1;
-
+    // The task sleeps until one of the deadline timers (or another task)
+    // posts an event, there is no periodic polling.
     while (true) {
-        vTaskDelayUntil(&lastWakeTime, period);   // 1 ms precision
-        msCounter++;
-        // handle LED controller stuff here
-        if (msCounter % kLedControllerUpdatePeriod == 0) {
-            self->mLedController.update();
+        uint32_t events = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &events, portMAX_DELAY);
+        self->mLoopWakeups++;
+        if (events & (kTimeChangedEvent | kSleepTransitionEvent)) {
+            self->mTimeKeeper.refresh();
+            self->handleSleepMode();
+            self->scheduleSleepTransition();
+        }
+        if (events & kTimeSyncedEvent) {
+            // Without a valid RTC time nothing was shown during the boot
+            if (!self->mIsTimeValid.exchange(true) && !self->isInSleepMode()) {
+                self->showCurrentTime();
+            }
+        }
+        if (events & kLedFrameEvent) {
+            self->handleLedFrame();
         }
-        // handle time and nixie clock stuff here
-        time_t now;
-        struct tm timeInfo;
-        time(&now);
-        localtime_r(&now, &timeInfo);
-        self->handleSleepMode();
-        if (timeInfo.tm_sec == 0 && lastSecond != 0 && !self->isInSleepMode()) {
-            self->startShowCurrentTimeTask();
+        if (events & kMinuteTickEvent) {
+            self->handleMinuteTick();
+        }
+        if (events & kMinuteAlarmEvent) {
+            self->handleMinuteAlarm();
+        }
+        if (events & kTemperatureEvent) {
+            if (!self->mRtc.sampleTemperature()) {
+                ESP_LOGW(kTag, "Failed to read RTC temperature");
+            }
         }
-        lastSecond = timeInfo.tm_sec;
     }
 }
 
-bool NixieClock::startShowCurrentTimeTask(void) {
-    // check if task is already running, if yes do not create another one
-    if (mShowCurrentTimeTaskHandle) {
+void NixieClock::timeTickCallback(const TimeSnapshot& snapshot,
+                                  void* param) {
+    NixieClock* self = static_cast<NixieClock*>(param);
+    // Runs every second in the esp_timer task, the loop task is woken up
+    // only when a new minute starts
+    if (self->mClockDiscipline.update()) {
+        xTaskNotify(self->mLoopTaskHandle, kTimeChangedEvent, eSetBits);
+    }
+    if (snapshot.minuteOfDay != self->mLastMinuteOfDay) {
+        if (self->mLastMinuteOfDay >= 0) {
+            xTaskNotify(self->mLoopTaskHandle, kMinuteTickEvent, eSetBits);
+        }
+        self->mLastMinuteOfDay = snapshot.minuteOfDay;
+    }
+}
+
+void NixieClock::ledTimerCallback(void* param) {
+    NixieClock* self = static_cast<NixieClock*>(param);
+    xTaskNotify(self->mLoopTaskHandle, kLedFrameEvent, eSetBits);
+}
+
+void NixieClock::sleepTimerCallback(void* param) {
+    NixieClock* self = static_cast<NixieClock*>(param);
+    xTaskNotify(self->mLoopTaskHandle, kSleepTransitionEvent, eSetBits);
+}
+
+void NixieClock::temperatureTimerCallback(void* param) {
+    NixieClock* self = static_cast<NixieClock*>(param);
+    xTaskNotify(self->mLoopTaskHandle, kTemperatureEvent, eSetBits);
+}
+
+bool NixieClock::enableLowPowerMode() {
+#if CONFIG_NIXIE_CLOCK_LOW_POWER
+    esp_err_t err =
+        mRtc.enableMinuteAlarm(kRtcSqwPin, minuteAlarmCallback, this);
+    if (err != ESP_OK) {
+        ESP_LOGE(kTag, "Failed to enable RTC minute alarm: %s",
+                 esp_err_to_name(err));
         return false;
     }
-    xTaskCreate(showCurrentTimeTask, "showCurrentTimeTask", 4096, this, 5,
-                &mShowCurrentTimeTaskHandle);
+    esp_pm_config_t pmConfig = {};
+    pmConfig.max_freq_mhz = CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ;
+    pmConfig.min_freq_mhz = kMinCpuFreqMhz;
+    pmConfig.light_sleep_enable = true;
+    ESP_ERROR_CHECK(esp_pm_configure(&pmConfig));
+    ESP_LOGI(kTag, "Low power mode enabled");
     return true;
+#else
+    return false;
+#endif
 }
 
-void NixieClock::showCurrentTimeTask(void* param) {
+void NixieClock::minuteAlarmCallback(void* param) {
     NixieClock* self = static_cast<NixieClock*>(param);
-    time_t now;
-    struct tm nowTm;
-    time(&now);
-    localtime_r(&now, &nowTm);
+    BaseType_t isHigherPriorityTaskWoken = pdFALSE;
+    xTaskNotifyFromISR(self->mLoopTaskHandle, kMinuteAlarmEvent, eSetBits,
+                       &isHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(isHigherPriorityTaskWoken);
+}
+
+void NixieClock::handleMinuteAlarm() {
+    if (!mRtc.acknowledgeAlarm()) {
+        ESP_LOGW(kTag, "Failed to acknowledge RTC alarm");
+    }
+    // The alarm marks the RTC minute, a system clock running slightly behind
+    // the RTC would still be in the previous minute
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    int64_t untilMinuteUs = (60 - tv.tv_sec % 60) * 1000000LL - tv.tv_usec;
+    if (untilMinuteUs < kMaxAlarmLeadUs) {
+        vTaskDelay(pdMS_TO_TICKS(untilMinuteUs / 1000 + 1));
+    }
+    // Runs the tick callback, so the minute logic and the clock discipline
+    // work as with the 1 s tick
+    mTimeKeeper.tick();
+}
+
+void NixieClock::scheduleSleepTransition() {
+    SleepInfo sleepInfo;
+    {
+        std::lock_guard<Mutex> lock(mMutex);
+        sleepInfo = mSleepInfo;
+    }
+    // The sleep mode is entered on the first minute after "sleep after" and
+    // left on the "sleep before" minute, arm the timer for the closer one
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    const TimeZone& timeZone = mTimeKeeper.getTimeZone();
+    time_t enter = nextLocalMinute(
+        timeZone, (sleepInfo.getSleepAfter() + 1) % kMinutesPerDay, tv.tv_sec);
+    time_t exit = nextLocalMinute(
+        timeZone, sleepInfo.getSleepBefore() % kMinutesPerDay, tv.tv_sec);
+    time_t next = std::min(enter, exit);
+    int64_t timeout = (next - tv.tv_sec) * 1000000LL - tv.tv_usec;
+    esp_timer_stop(mSleepTimer);   // may not be running, ignore the result
+    ESP_ERROR_CHECK(
+        esp_timer_start_once(mSleepTimer, timeout + kSleepTransitionGuardUs));
+
+    struct tm nextTm;
+    timeZone.toLocal(next, &nextTm);
     char buf[32];
-    strftime(buf, sizeof(buf), "%H:%M:%S", &nowTm);
-    ESP_LOGI(kTag, "Current time: %s", buf);
-    LedInfo ledInfo = self->mLedController.getLedInfo();
-    if (ledInfo.getState() != LedState::Off) {
-        ledInfo.setState(LedState::On);
-        self->mLedController.setTemporalState(ledInfo);
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M", &nextTm);
+    ESP_LOGI(kTag, "Next sleep mode transition: %s", buf);
+}
+
+void NixieClock::requestLedUpdate() {
+    // The LED belongs to the boot test until it is finished
+    if (mLoopTaskHandle && mIsLedReady) {
+        xTaskNotify(mLoopTaskHandle, kLedFrameEvent, eSetBits);
+    }
+}
+
+void NixieClock::handleLedFrame() {
+    // Only animated effects need a frame clock, the timer is armed for the
+    // next distinct frame or for releasing the LED channel after a static
+    // frame. The timer is owned by the loop task only.
+    if (esp_timer_is_active(mLedTimer)) {
+        esp_timer_stop(mLedTimer);
     }
-    // Show a fast countdown of digits from 9 to 0 on nixie tube as an intro
-    // before showing the actual time
-    for (auto i = 9; i >= 0; --i) {
-        self->mNixieTube.showDigit(i);
-        vTaskDelay(kIntroDigitPeriod / portTICK_PERIOD_MS);
+    uint32_t nextFrameMs = mLedController.update();
+    if (nextFrameMs > 0) {
+        // Light sleep between frames would only delay them
+        mLedPmLock.acquire();
+        ESP_ERROR_CHECK(esp_timer_start_once(mLedTimer, nextFrameMs * 1000));
+    } else {
+        mLedPmLock.release();
     }
-    self->mNixieTube.hideDigit();
-    vTaskDelay(kShowTimeDelay / portTICK_PERIOD_MS);
-    // Show time on nixie tube. Since there is only one nixie tube it is
-    // needed to sequentially show digits. The time is displayed in the
-    // following format: H <pause> H <pause> M <pause> M
+}
+
+void NixieClock::handleMinuteTick() {
+    ESP_LOGI(kTag, "Loop task wakeups in the last minute: %" PRIu32,
+             mLoopWakeups);
+    mLoopWakeups = 0;
+    LedFrameStats ledStats = mLedController.getFrameStats();
+    ESP_LOGI(kTag, "LED frames rendered: %" PRIu32 ", sent: %" PRIu32,
+             ledStats.rendered, ledStats.sent);
+    if (mIsTimeValid && !isInSleepMode()) {
+        showCurrentTime();
+    }
+}
+
+void NixieClock::showCurrentTime() {
+    struct tm nowTm = mTimeKeeper.getSnapshot().local;
+    char buf[32];
+    strftime(buf, sizeof(buf), "%H:%M:%S", &nowTm);
+    ESP_LOGI(kTag, "Current time: %s", buf);
     // handle 24 and 12 hour formats
     uint8_t hour = nowTm.tm_hour;
     {
-        std::lock_guard<Mutex> lock(self->mMutex);
-        if (self->mTimeInfo.getTimeFormat() == TimeFormat::Hour12) {
+        std::lock_guard<Mutex> lock(mMutex);
+        if (mTimeInfo.getTimeFormat() == TimeFormat::Hour12) {
             hour = nowTm.tm_hour % 12;
             if (hour == 0) {
                 hour = 12;
             }
         }
     }
-    int32_t nixieOutput[] = {hour / 10, hour % 10, nowTm.tm_min / 10,
-                             nowTm.tm_min % 10};
-    for (auto i = 0; i < kCurrentTimeRepeatTimes; ++i) {
-        for (auto j = 0; j < sizeof(nixieOutput) / sizeof(nixieOutput[0]);
-             ++j) {
-            self->mNixieTube.showDigit(nixieOutput[j]);
-            vTaskDelay(kDigitDuration / portTICK_PERIOD_MS);
-            self->mNixieTube.hideDigit();
-            if (j < sizeof(nixieOutput) / sizeof(nixieOutput[0] - 1)) {
-                vTaskDelay(kDigitDuration / portTICK_PERIOD_MS);
-            }
-        }
-        if (i < kCurrentTimeRepeatTimes - 1) {
-            vTaskDelay(kPauseDuration / portTICK_PERIOD_MS);
-        }
+    mDisplayWorker.showTime(hour, nowTm.tm_min);
+}
+
+void NixieClock::onDisplayStarted() {
+    mDisplayPmLock.acquire();
+    if (!mIsFirstDigitShown) {
+        mIsFirstDigitShown = true;
+        ESP_LOGI(kTag, "Time to first digit: %lld ms",
+                 (esp_timer_get_time() - mBootStartUs) / 1000);
     }
-    self->mLedController.clearTemporalState();
-    self->mShowCurrentTimeTaskHandle = nullptr;
-    vTaskDelete(nullptr);
+    LedInfo ledInfo = mLedController.getLedInfo();
+    if (ledInfo.getState() != LedState::Off) {
+        ledInfo.setState(LedState::On);
+        mLedController.setTemporalState(ledInfo);
+        requestLedUpdate();
+    }
+}
+
+void NixieClock::onDisplayFinished() {
+    mLedController.clearTemporalState();
+    requestLedUpdate();
+    mDisplayPmLock.release();
 }
 
 void NixieClock::handleSleepMode() {
-    bool currentSleepModeStatus = isInSleepMode();
+    int32_t minuteOfDay = mTimeKeeper.getSnapshot().minuteOfDay;
     std::lock_guard<Mutex> lock(mMutex);
+    bool currentSleepModeStatus = isInSleepWindow(mSleepInfo, minuteOfDay);
     if (mLastSleepModeStatus != currentSleepModeStatus) {
         mLastSleepModeStatus = currentSleepModeStatus;
         if (mLastSleepModeStatus) {
@@ -406,28 +681,8 @@ void NixieClock::handleSleepMode() {
             mLedController.setLedInfo(ledInfo);
         } else {
             ESP_LOGI(kTag, "Exiting sleep mode.");
-            LedInfo ledInfo = ConfigStore::loadLedInfo().value_or(LedInfo());
-            mLedController.setLedInfo(ledInfo);
+            mLedController.setLedInfo(mLedInfo);
         }
+        requestLedUpdate();
     }
 }
-
-time_t NixieClock::timegmRtc(struct tm* tm) {
-    // Save current TZ
-    char* oldTz = getenv("TZ");
-    if (oldTz)
-        oldTz = strdup(oldTz);   // copy for restore
-    // Set TZ to UTC
-    setenv("TZ", "UTC0", 1);
-    tzset();
-    time_t t = mktime(tm);   // mktime now treats tm as UTC
-    // Restore previous TZ
-    if (oldTz) {
-        setenv("TZ", oldTz, 1);
-        free(oldTz);
-    } else {
-        unsetenv("TZ");
-    }
-    tzset();
-    return t;
-}
\ No newline at end of file
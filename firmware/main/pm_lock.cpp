@@ -0,0 +1,36 @@
+/******************************************************************************
+ * File:    pm_lock.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Implements PmLock class
+ ******************************************************************************/
+
+#include "pm_lock.h"
+
+PmLock::PmLock(const char* name) : mHandle(nullptr), mIsHeld(false) {
+#if CONFIG_PM_ENABLE
+    ESP_ERROR_CHECK(esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, name,
+                                       &mHandle));
+#else
+    (void) name;
+#endif
+}
+
+PmLock::~PmLock() {
+    release();
+    if (mHandle) {
+        esp_pm_lock_delete(mHandle);
+    }
+}
+
+void PmLock::acquire() {
+    if (mHandle && !mIsHeld.exchange(true)) {
+        esp_pm_lock_acquire(mHandle);
+    }
+}
+
+void PmLock::release() {
+    if (mHandle && mIsHeld.exchange(false)) {
+        esp_pm_lock_release(mHandle);
+    }
+}
@@ -0,0 +1,121 @@
+/******************************************************************************
+ * File:    rtc_calibrator.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Implements RtcCalibrator class
+ ******************************************************************************/
+
+#include "rtc_calibrator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#include <mutex>
+
+#include "esp_log.h"
+
+#include "config_store.h"
+
+static const char* kTag = "rtc_calibrator";
+static constexpr int64_t kMaxRtcOffsetUs = 20000;   // rewrite the RTC above
+static constexpr uint8_t kMinFitSamples = 3;
+static constexpr time_t kMinFitSpan = 6 * 3600;      // s
+static constexpr double kAgingLsbPpm = 0.1;          // DS3231 at 25 °C
+static constexpr double kLowDriftPpm = 0.2;
+static constexpr uint32_t kMinSyncInterval = 3600000;    // 1 hour
+static constexpr uint32_t kMaxSyncInterval = 86400000;   // 1 day
+
+RtcCalibrator::RtcCalibrator(Ds3231& rtc)
+    : mRtc(rtc), mSamples{}, mSampleCount(0), mCorrectionUs(0),
+      mSyncInterval(kMinSyncInterval) {}
+
+void RtcCalibrator::initialize() {
+    mInfo = ConfigStore::loadCalibrationInfo().value_or(CalibrationInfo());
+    mSyncInterval = std::clamp(mInfo.getSyncInterval(), kMinSyncInterval,
+                               kMaxSyncInterval);
+    if (!mRtc.setAgingOffset(mInfo.getAgingOffset())) {
+        ESP_LOGE(kTag, "Failed to set RTC aging offset");
+    }
+    ESP_LOGI(kTag, "Aging offset: %d, drift: %" PRId32 " ppb",
+             mInfo.getAgingOffset(), mInfo.getDriftPpb());
+}
+
+bool RtcCalibrator::addSample(time_t utc, int64_t offsetUs) {
+    if (mSampleCount == kMaxSamples) {
+        std::copy(mSamples + 1, mSamples + kMaxSamples, mSamples);
+        mSampleCount--;
+    }
+    mSamples[mSampleCount++] = {utc, offsetUs + mCorrectionUs};
+    ESP_LOGI(kTag, "RTC offset: %lld us", offsetUs);
+    fit();
+
+    if (llabs(offsetUs) > kMaxRtcOffsetUs) {
+        // The RTC is set to the system time, the offset so far is kept as a
+        // correction of the following samples
+        mCorrectionUs += offsetUs;
+        return true;
+    }
+    return false;
+}
+
+uint32_t RtcCalibrator::getSyncInterval() const { return mSyncInterval; }
+
+CalibrationInfo RtcCalibrator::getCalibrationInfo() const {
+    std::lock_guard<Mutex> lock(mMutex);
+    return mInfo;
+}
+
+void RtcCalibrator::fit() {
+    if (mSampleCount < kMinFitSamples ||
+        mSamples[mSampleCount - 1].utc - mSamples[0].utc < kMinFitSpan) {
+        return;
+    }
+
+    // Least squares slope of the phase, us per s equals ppm
+    double meanT = 0;
+    double meanPhase = 0;
+    for (uint8_t i = 0; i < mSampleCount; ++i) {
+        meanT += mSamples[i].utc - mSamples[0].utc;
+        meanPhase += mSamples[i].phaseUs;
+    }
+    meanT /= mSampleCount;
+    meanPhase /= mSampleCount;
+    double covariance = 0;
+    double variance = 0;
+    for (uint8_t i = 0; i < mSampleCount; ++i) {
+        double dt = mSamples[i].utc - mSamples[0].utc - meanT;
+        covariance += dt * (mSamples[i].phaseUs - meanPhase);
+        variance += dt * dt;
+    }
+    double driftPpm = covariance / variance;
+
+    std::lock_guard<Mutex> lock(mMutex);
+    mInfo.setDriftPpb(std::lround(driftPpm * 1000));
+    // A fast RTC (positive drift) is slowed down by a larger aging offset
+    long step = std::lround(driftPpm / kAgingLsbPpm);
+    if (step != 0) {
+        int8_t agingOffset =
+            std::clamp<long>(mInfo.getAgingOffset() + step, INT8_MIN, INT8_MAX);
+        if (mRtc.setAgingOffset(agingOffset)) {
+            mInfo.setAgingOffset(agingOffset);
+            // The rate changed, the older samples do not describe it anymore
+            mSamples[0] = mSamples[mSampleCount - 1];
+            mSampleCount = 1;
+        } else {
+            ESP_LOGE(kTag, "Failed to set RTC aging offset");
+        }
+    }
+
+    uint32_t syncInterval = kMinSyncInterval;
+    if (std::fabs(driftPpm) < kLowDriftPpm) {
+        syncInterval = std::min(mSyncInterval * 2, kMaxSyncInterval);
+    }
+    mSyncInterval = syncInterval;
+    mInfo.setSyncInterval(syncInterval);
+    ConfigStore::saveCalibrationInfo(mInfo);
+    ESP_LOGI(kTag,
+             "Drift: %" PRId32 " ppb, aging offset: %d, sync interval: %" PRIu32
+             " s",
+             mInfo.getDriftPpb(), mInfo.getAgingOffset(), syncInterval / 1000);
+}
@@ -0,0 +1,271 @@
+/******************************************************************************
+ * File:    sntp_manager.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Implements SntpManager class
+ ******************************************************************************/
+
+#include "sntp_manager.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#include "esp_log.h"
+#include "esp_sntp.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/netdb.h"
+#include "lwip/sockets.h"
+
+static const char* kTag = "sntp_manager";
+static constexpr int64_t kSlewThresholdUs = 500000;   // step above
+static constexpr int64_t kStableOffsetUs = 10000;
+static constexpr int64_t kUnstableOffsetUs = 100000;
+static constexpr uint8_t kStableSyncs = 2;   // before the interval doubles
+static constexpr uint32_t kMinSyncInterval = 900000;     // 15 minutes
+static constexpr uint32_t kMaxSyncInterval = 86400000;   // 1 day
+static constexpr uint32_t kDefaultSyncInterval = 3600000;   // 1 hour
+static constexpr int kProbeTimeoutMs = 1000;
+static constexpr size_t kNtpPacketSize = 48;
+static constexpr uint8_t kNtpClientRequest = 0x23;   // LI 0, version 4, client
+
+static SntpManager* gSntpManagerPtr = nullptr;
+
+// Overrides the weak implementation of ESP-IDF, called by the lwIP task
+extern "C" void sntp_sync_time(struct timeval* tv) {
+    if (gSntpManagerPtr) {
+        gSntpManagerPtr->syncTime(tv);
+    } else {
+        settimeofday(tv, nullptr);
+        sntp_set_sync_status(SNTP_SYNC_STATUS_COMPLETED);
+    }
+}
+
+/**
+ * @brief Read a 64-bit NTP timestamp (32.32 fixed point, big endian)
+ */
+static uint64_t readNtpTimestamp(const uint8_t* buf) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value = (value << 8) | buf[i];
+    }
+    return value;
+}
+
+SntpManager::SntpManager()
+    : mCallback(nullptr), mCallbackArg(nullptr), mHasPendingServers(false),
+      mIsProbeRunning(false), mServerNames{}, mIsStarted(false), mSyncCount(0),
+      mLastSync(0), mLastOffsetUs(0), mWasStepped(false),
+      mSyncInterval(kDefaultSyncInterval), mMaxSyncInterval(kMaxSyncInterval),
+      mStableCount(0) {}
+
+void SntpManager::initialize(const std::vector<std::string>& servers,
+                             SyncCallback callback, void* arg) {
+    mCallback = callback;
+    mCallbackArg = arg;
+    gSntpManagerPtr = this;
+    {
+        std::lock_guard<Mutex> lock(mMutex);
+        mPendingServers = servers;
+    }
+    probeAndStart();
+}
+
+void SntpManager::setServers(const std::vector<std::string>& servers) {
+    {
+        std::lock_guard<Mutex> lock(mMutex);
+        if (servers == mPendingServers) {
+            return;
+        }
+        mPendingServers = servers;
+        mHasPendingServers = true;
+        // Not running yet, initialize() picks the servers up. A running
+        // probe task probes the new list before it exits.
+        if (!mIsStarted || mIsProbeRunning) {
+            return;
+        }
+        mIsProbeRunning = true;
+    }
+    if (xTaskCreate(probeTask, "sntpProbe", 4096, this, 1, nullptr) !=
+        pdPASS) {
+        ESP_LOGE(kTag, "Failed to start the probe task");
+        std::lock_guard<Mutex> lock(mMutex);
+        mIsProbeRunning = false;
+    }
+}
+
+void SntpManager::setMaxSyncInterval(uint32_t interval) {
+    std::lock_guard<Mutex> lock(mMutex);
+    mMaxSyncInterval =
+        std::clamp(interval, kMinSyncInterval, kMaxSyncInterval);
+}
+
+SyncStatus SntpManager::getStatus() const {
+    std::lock_guard<Mutex> lock(mMutex);
+    SyncStatus status = {};
+    status.isSynced = mSyncCount > 0;
+    status.syncCount = mSyncCount;
+    status.lastSync = mLastSync;
+    status.lastOffsetUs = mLastOffsetUs;
+    status.wasStepped = mWasStepped;
+    status.syncInterval = std::min(mSyncInterval, mMaxSyncInterval);
+    status.servers = mServers;
+    return status;
+}
+
+void SntpManager::syncTime(struct timeval* tv) {
+    struct timeval now;
+    gettimeofday(&now, nullptr);
+    int64_t offsetUs = (tv->tv_sec - now.tv_sec) * 1000000LL +
+                       (tv->tv_usec - now.tv_usec);
+    bool isStep = llabs(offsetUs) > kSlewThresholdUs;
+    if (!isStep) {
+        struct timeval delta = {
+            .tv_sec = static_cast<time_t>(offsetUs / 1000000),
+            .tv_usec = static_cast<suseconds_t>(offsetUs % 1000000)};
+        isStep = adjtime(&delta, nullptr) != 0;
+    }
+    if (isStep) {
+        settimeofday(tv, nullptr);
+    }
+    sntp_set_sync_status(SNTP_SYNC_STATUS_COMPLETED);
+    if (mCallback) {
+        mCallback(mCallbackArg);
+    }
+
+    uint32_t interval;
+    {
+        std::lock_guard<Mutex> lock(mMutex);
+        mSyncCount++;
+        mLastSync = tv->tv_sec;
+        mLastOffsetUs = offsetUs;
+        mWasStepped = isStep;
+        interval = adaptSyncInterval(offsetUs);
+    }
+    sntp_set_sync_interval(interval);
+    ESP_LOGI(kTag, "Offset %lld us %s, next sync in %" PRIu32 " s", offsetUs,
+             isStep ? "stepped" : "slewed", interval / 1000);
+}
+
+void SntpManager::probeTask(void* param) {
+    SntpManager* self = static_cast<SntpManager*>(param);
+    while (true) {
+        self->probeAndStart();
+        std::lock_guard<Mutex> lock(self->mMutex);
+        if (!self->mHasPendingServers) {
+            self->mIsProbeRunning = false;
+            break;
+        }
+    }
+    vTaskDelete(nullptr);
+}
+
+void SntpManager::probeAndStart() {
+    std::vector<std::string> servers;
+    {
+        std::lock_guard<Mutex> lock(mMutex);
+        servers = mPendingServers;
+        mHasPendingServers = false;
+    }
+
+    std::vector<NtpServerStatus> statuses;
+    for (const std::string& server : servers) {
+        int32_t rttMs = measureRtt(server);
+        ESP_LOGI(kTag, "Server %s, round-trip time: %" PRId32 " ms",
+                 server.c_str(), rttMs);
+        statuses.push_back({server, rttMs});
+    }
+    // Fastest first, servers which did not reply last
+    std::stable_sort(statuses.begin(), statuses.end(),
+                     [](const NtpServerStatus& a, const NtpServerStatus& b) {
+                         if (a.rttMs < 0 || b.rttMs < 0) {
+                             return a.rttMs >= 0 && b.rttMs < 0;
+                         }
+                         return a.rttMs < b.rttMs;
+                     });
+
+    if (mIsStarted) {
+        esp_sntp_stop();
+    }
+    for (uint8_t i = 0; i < kMaxServers; ++i) {
+        if (i < statuses.size()) {
+            strlcpy(mServerNames[i], statuses[i].name.c_str(),
+                    kMaxServerNameLen);
+            esp_sntp_setservername(i, mServerNames[i]);
+        } else {
+            esp_sntp_setservername(i, nullptr);
+        }
+    }
+    uint32_t interval;
+    {
+        std::lock_guard<Mutex> lock(mMutex);
+        mServers = statuses;
+        interval = std::min(mSyncInterval, mMaxSyncInterval);
+    }
+    esp_sntp_setoperatingmode(ESP_SNTP_OPMODE_POLL);
+    esp_sntp_set_sync_interval(interval);
+    esp_sntp_init();
+    mIsStarted = true;
+}
+
+int32_t SntpManager::measureRtt(const std::string& server) {
+    struct addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    struct addrinfo* result = nullptr;
+    if (getaddrinfo(server.c_str(), "123", &hints, &result) != 0 || !result) {
+        return -1;
+    }
+    int sock = socket(result->ai_family, result->ai_socktype, 0);
+    if (sock < 0) {
+        freeaddrinfo(result);
+        return -1;
+    }
+    struct timeval timeout = {.tv_sec = 0,
+                              .tv_usec = kProbeTimeoutMs * 1000};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    uint8_t packet[kNtpPacketSize] = {kNtpClientRequest};
+    int64_t sentUs = esp_timer_get_time();
+    int received = -1;
+    if (sendto(sock, packet, sizeof(packet), 0, result->ai_addr,
+               result->ai_addrlen) == sizeof(packet)) {
+        received = recv(sock, packet, sizeof(packet), 0);
+    }
+    int64_t receivedUs = esp_timer_get_time();
+    close(sock);
+    freeaddrinfo(result);
+    if (received != sizeof(packet)) {
+        return -1;
+    }
+
+    // Exclude the time the server spent between receive (bytes 32..39) and
+    // transmit (bytes 40..47) timestamps
+    int64_t serverTicks = static_cast<int64_t>(readNtpTimestamp(&packet[40]) -
+                                               readNtpTimestamp(&packet[32]));
+    int64_t serverUs = (serverTicks * 1000000) >> 32;
+    int64_t rttUs = receivedUs - sentUs - std::max<int64_t>(serverUs, 0);
+    return std::max<int64_t>(rttUs, 0) / 1000;
+}
+
+uint32_t SntpManager::adaptSyncInterval(int64_t offsetUs) {
+    // The first offset after boot only tells how good the RTC was
+    if (mSyncCount > 1) {
+        if (llabs(offsetUs) <= kStableOffsetUs) {
+            if (++mStableCount >= kStableSyncs) {
+                mSyncInterval = std::min(mSyncInterval * 2, mMaxSyncInterval);
+                mStableCount = 0;
+            }
+        } else if (llabs(offsetUs) > kUnstableOffsetUs) {
+            mSyncInterval = std::max(mSyncInterval / 2, kMinSyncInterval);
+            mStableCount = 0;
+        } else {
+            mStableCount = 0;
+        }
+    }
+    // The hint may have dropped since the interval was last doubled
+    return std::min(mSyncInterval, mMaxSyncInterval);
+}
@@ -0,0 +1,71 @@
+/******************************************************************************
+ * File:    temperature_history.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Implementation of a ring buffer of temperature samples
+ ******************************************************************************/
+
+#include "temperature_history.h"
+
+#include <algorithm>
+#include <mutex>
+
+static constexpr float kDegreesPerLsb = 0.25f;
+
+TemperatureHistory::TemperatureHistory()
+    : mSamples{}, mHead(0), mCount(0) {}
+
+void TemperatureHistory::add(int16_t quarterDegrees) {
+    std::lock_guard<Mutex> lock(mMutex);
+    mSamples[mHead] = quarterDegrees;
+    mHead = (mHead + 1) % kCapacity;
+    if (mCount < kCapacity) {
+        mCount++;
+    }
+}
+
+TemperatureStats TemperatureHistory::getStats(size_t points,
+                                              uint32_t sampleInterval) const {
+    TemperatureStats stats = {};
+    stats.sampleInterval = sampleInterval;
+
+    std::lock_guard<Mutex> lock(mMutex);
+    stats.sampleCount = mCount;
+    if (mCount == 0) {
+        return stats;
+    }
+
+    int16_t minValue = at(0);
+    int16_t maxValue = at(0);
+    int32_t sum = 0;
+    for (size_t i = 0; i < mCount; i++) {
+        int16_t value = at(i);
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+        sum += value;
+    }
+    stats.current = at(mCount - 1) * kDegreesPerLsb;
+    stats.min = minValue * kDegreesPerLsb;
+    stats.max = maxValue * kDegreesPerLsb;
+    stats.average = static_cast<float>(sum) / mCount * kDegreesPerLsb;
+
+    // Bucket i covers samples [i * count / points, (i + 1) * count / points)
+    points = std::min(points, mCount);
+    stats.series.reserve(points);
+    for (size_t i = 0; i < points; i++) {
+        size_t first = i * mCount / points;
+        size_t last = (i + 1) * mCount / points;
+        int32_t bucketSum = 0;
+        for (size_t j = first; j < last; j++) {
+            bucketSum += at(j);
+        }
+        stats.series.push_back(static_cast<float>(bucketSum) /
+                               (last - first) * kDegreesPerLsb);
+    }
+    return stats;
+}
+
+int16_t TemperatureHistory::at(size_t index) const {
+    // index 0 is the oldest sample
+    return mSamples[(mHead + kCapacity - mCount + index) % kCapacity];
+}
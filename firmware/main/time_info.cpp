@@ -7,17 +7,61 @@
 
 #include "time_info.h"
 
-TimeInfo::TimeInfo(const std::string& tzZone, const std::string& tzOffset)
-    : mTzZone(tzZone), mTzOffset(tzOffset), mTimeFormat(TimeFormat::Hour24) {}
+#include <cstring>
 
-std::string TimeInfo::getTzZone() const { return mTzZone; }
+/**
+ * @brief Copy a string into a fixed-size buffer
+ *
+ * @return False if the string does not fit, the buffer is left unchanged
+ */
+static bool copyString(char* buffer, size_t size, const char* value) {
+    size_t length = strlen(value);
+    if (length >= size) {
+        return false;
+    }
+    memcpy(buffer, value, length + 1);
+    return true;
+}
 
-void TimeInfo::setTzZone(const std::string& value) { mTzZone = value; }
+TimeInfo::TimeInfo(const char* tzZone, const char* tzOffset) {
+    setTzZone(tzZone);
+    setTzOffset(tzOffset);
+}
 
-std::string TimeInfo::getTzOffset() const { return mTzOffset; }
+const char* TimeInfo::getTzZone() const { return mTzZone; }
 
-void TimeInfo::setTzOffset(const std::string& value) { mTzOffset = value; }
+bool TimeInfo::setTzZone(const char* value) {
+    return copyString(mTzZone, sizeof(mTzZone), value);
+}
+
+const char* TimeInfo::getTzOffset() const { return mTzOffset; }
+
+bool TimeInfo::setTzOffset(const char* value) {
+    return copyString(mTzOffset, sizeof(mTzOffset), value);
+}
 
 TimeFormat TimeInfo::getTimeFormat() const { return mTimeFormat; }
 
-void TimeInfo::setTimeFormat(TimeFormat value) { mTimeFormat = value; }
\ No newline at end of file
+void TimeInfo::setTimeFormat(TimeFormat value) { mTimeFormat = value; }
+
+uint8_t TimeInfo::getNtpServerCount() const { return mNtpServerCount; }
+
+const char* TimeInfo::getNtpServer(uint8_t index) const {
+    return mNtpServers[index];
+}
+
+std::vector<std::string> TimeInfo::getNtpServers() const {
+    return std::vector<std::string>(mNtpServers,
+                                    mNtpServers + mNtpServerCount);
+}
+
+void TimeInfo::clearNtpServers() { mNtpServerCount = 0; }
+
+bool TimeInfo::addNtpServer(const char* value) {
+    if (mNtpServerCount == kMaxNtpServers ||
+        !copyString(mNtpServers[mNtpServerCount], kNtpServerSize, value)) {
+        return false;
+    }
+    mNtpServerCount++;
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+/******************************************************************************
+ * File:    time_keeper.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Implements TimeKeeper class
+ ******************************************************************************/
+
+#include "time_keeper.h"
+
+#include <mutex>
+#include <sys/time.h>
+
+static constexpr int64_t kTickGuardUs = 1000;   // tick 1 ms past the second
+
+TimeKeeper::TimeKeeper()
+    : mTimer(nullptr), mCallback(nullptr), mCallbackArg(nullptr) {}
+
+void TimeKeeper::initialize(TickCallback callback, void* arg,
+                            bool hasTimer) {
+    mCallback = callback;
+    mCallbackArg = arg;
+    if (!hasTimer) {
+        publish();
+        return;
+    }
+
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = timerCallback;
+    timerArgs.arg = this;
+    timerArgs.dispatch_method = ESP_TIMER_TASK;
+    timerArgs.name = "timeKeeper";
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &mTimer));
+
+    refresh();
+}
+
+void TimeKeeper::refresh() {
+    publish();
+    if (mTimer) {
+        scheduleNextTick();
+    }
+}
+
+void TimeKeeper::tick() {
+    refresh();
+    if (mCallback) {
+        mCallback(getSnapshot(), mCallbackArg);
+    }
+}
+
+bool TimeKeeper::setTimeZone(const std::string& posixTz) {
+    return mTimeZone.setRule(posixTz);
+}
+
+const TimeZone& TimeKeeper::getTimeZone() const { return mTimeZone; }
+
+TimeSnapshot TimeKeeper::getSnapshot() const { return mSnapshot.load(); }
+
+void TimeKeeper::timerCallback(void* param) {
+    TimeKeeper* self = static_cast<TimeKeeper*>(param);
+    self->tick();
+}
+
+void TimeKeeper::publish() {
+    std::lock_guard<Mutex> lock(mWriterMutex);
+    TimeSnapshot snapshot;
+    time(&snapshot.utc);
+    mTimeZone.toLocal(snapshot.utc, &snapshot.local);
+    snapshot.minuteOfDay = snapshot.local.tm_hour * 60 + snapshot.local.tm_min;
+    mSnapshot.store(snapshot);
+}
+
+void TimeKeeper::scheduleNextTick() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    esp_timer_stop(mTimer);   // may not be running, ignore the result
+    ESP_ERROR_CHECK(
+        esp_timer_start_once(mTimer, 1000000 - tv.tv_usec + kTickGuardUs));
+}
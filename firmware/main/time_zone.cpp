@@ -0,0 +1,340 @@
+/******************************************************************************
+ * File:    time_zone.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Implements TimeZone class
+ ******************************************************************************/
+
+#include "time_zone.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <limits>
+#include <mutex>
+
+#include "esp_log.h"
+
+#include "civil_time.h"
+
+static const char* kTag = "time_zone";
+static constexpr int32_t kSecondsPerHour = 3600;
+static constexpr int32_t kSecondsPerDay = 24 * kSecondsPerHour;
+static constexpr int32_t kMaxOffsetHours = 24;
+static constexpr int32_t kMaxTransitionHours = 167;
+static constexpr int32_t kDefaultTransitionTime = 2 * kSecondsPerHour;
+// Used when the rule has a DST but no transitions, as newlib does
+static constexpr const char* kDefaultTransitions = ",M3.2.0,M11.1.0";
+static constexpr time_t kTimeMin = std::numeric_limits<time_t>::min();
+static constexpr time_t kTimeMax = std::numeric_limits<time_t>::max();
+
+/**
+ * @brief Parse a zone name, "CET" or "<+0330>"
+ *
+ * @return pointer past the name or nullptr
+ */
+static const char* parseName(const char* text) {
+    const char* end = text;
+    if (*text == '<') {
+        for (end = text + 1; *end != '>'; end++) {
+            if (!isalnum(static_cast<unsigned char>(*end)) && *end != '+' &&
+                *end != '-') {
+                return nullptr;
+            }
+        }
+        return end - text - 1 >= 3 ? end + 1 : nullptr;
+    }
+    while (isalpha(static_cast<unsigned char>(*end))) {
+        end++;
+    }
+    return end - text >= 3 ? end : nullptr;
+}
+
+/**
+ * @brief Parse a decimal number in a range
+ *
+ * @return pointer past the number or nullptr
+ */
+static const char* parseNumber(const char* text, int32_t min, int32_t max,
+                               int32_t* value) {
+    if (!isdigit(static_cast<unsigned char>(*text))) {
+        return nullptr;
+    }
+    int32_t number = 0;
+    while (isdigit(static_cast<unsigned char>(*text))) {
+        number = number * 10 + (*text++ - '0');
+        if (number > max) {
+            return nullptr;
+        }
+    }
+    if (number < min) {
+        return nullptr;
+    }
+    *value = number;
+    return text;
+}
+
+/**
+ * @brief Parse [+|-]hh[:mm[:ss]] into seconds
+ *
+ * @return pointer past the time or nullptr
+ */
+static const char* parseTime(const char* text, int32_t maxHours,
+                             int32_t* seconds) {
+    int32_t sign = 1;
+    if (*text == '+' || *text == '-') {
+        sign = *text == '-' ? -1 : 1;
+        text++;
+    }
+    int32_t hours = 0;
+    int32_t minutes = 0;
+    int32_t secs = 0;
+    text = parseNumber(text, 0, maxHours, &hours);
+    if (text && *text == ':') {
+        text = parseNumber(text + 1, 0, 59, &minutes);
+        if (text && *text == ':') {
+            text = parseNumber(text + 1, 0, 59, &secs);
+        }
+    }
+    if (text) {
+        *seconds = sign * (hours * kSecondsPerHour + minutes * 60 + secs);
+    }
+    return text;
+}
+
+/**
+ * @brief Parse Jn, n or Mm.w.d with an optional /time
+ *
+ * @return pointer past the transition or nullptr
+ */
+static const char* parseTransition(const char* text, TzTransition* transition) {
+    int32_t value = 0;
+    *transition = {};
+    if (*text == 'M') {
+        transition->type = TzTransition::Type::MonthWeekDay;
+        text = parseNumber(text + 1, 1, 12, &value);
+        transition->month = value;
+        if (text && *text == '.') {
+            text = parseNumber(text + 1, 1, 5, &value);
+            transition->week = value;
+        } else {
+            return nullptr;
+        }
+        if (text && *text == '.') {
+            text = parseNumber(text + 1, 0, 6, &value);
+            transition->weekday = value;
+        } else {
+            return nullptr;
+        }
+    } else if (*text == 'J') {
+        transition->type = TzTransition::Type::Julian;
+        text = parseNumber(text + 1, 1, 365, &value);
+        transition->day = value;
+    } else {
+        transition->type = TzTransition::Type::ZeroJulian;
+        text = parseNumber(text, 0, 365, &value);
+        transition->day = value;
+    }
+    transition->time = kDefaultTransitionTime;
+    if (text && *text == '/') {
+        text = parseTime(text + 1, kMaxTransitionHours, &transition->time);
+    }
+    return text;
+}
+
+/**
+ * @brief Get the day of a transition in a year
+ *
+ * @return days since the epoch
+ */
+static int32_t transitionDay(const TzTransition& transition, int32_t year) {
+    const int32_t newYear = daysFromCivil(year, 1, 1);
+    switch (transition.type) {
+    case TzTransition::Type::Julian: {
+        bool isLeapYear = daysFromCivil(year, 3, 1) - newYear == 60;
+        return newYear + transition.day - 1 +
+               (isLeapYear && transition.day >= 60);
+    }
+    case TzTransition::Type::ZeroJulian:
+        return newYear + transition.day;
+    case TzTransition::Type::MonthWeekDay:
+    default: {
+        const int32_t first = daysFromCivil(year, transition.month, 1);
+        const int32_t next = transition.month == 12
+                                 ? daysFromCivil(year + 1, 1, 1)
+                                 : daysFromCivil(year, transition.month + 1, 1);
+        int32_t day = first +
+                      (transition.weekday + 7 - weekdayFromDays(first)) % 7 +
+                      (transition.week - 1) * 7;
+        // Week 5 is the last week, which may be the 4th
+        while (day >= next) {
+            day -= 7;
+        }
+        return day;
+    }
+    }
+}
+
+TimeZone::TimeZone() : mRule{} {
+    mCache.store({kTimeMin, kTimeMax, 0, false});
+}
+
+bool TimeZone::setRule(const std::string& posixTz) {
+    TzRule rule;
+    bool isValid = parseRule(posixTz.c_str(), &rule);
+    if (!isValid) {
+        ESP_LOGW(kTag, "Invalid TZ rule '%s', using UTC", posixTz.c_str());
+        rule = {};
+    }
+    std::lock_guard<Mutex> lock(mWriterMutex);
+    mRule = rule;
+    // An empty interval, the next conversion computes the offset
+    mCache.store({kTimeMax, kTimeMin, 0, false});
+    return isValid;
+}
+
+int32_t TimeZone::getUtcOffset(time_t utc, bool* isDst) const {
+    CachedOffset cached = lookup(utc, true);
+    if (isDst) {
+        *isDst = cached.isDst;
+    }
+    return cached.offset;
+}
+
+void TimeZone::toLocal(time_t utc, struct tm* local) const {
+    bool isDst = false;
+    int32_t offset = getUtcOffset(utc, &isDst);
+    gmtimeUtc(utc + offset, local);
+    local->tm_isdst = isDst;
+}
+
+time_t TimeZone::toUtc(const struct tm& local) const {
+    // Lookups far from now do not replace the cached offset
+    const time_t localSeconds = timegmUtc(local);
+    const CachedOffset guess = lookup(localSeconds, false);
+    const CachedOffset interval = lookup(localSeconds - guess.offset, false);
+    time_t utc = localSeconds - interval.offset;
+    if (utc >= interval.from && utc < interval.until) {
+        // After a backward transition the local time may occur earlier too
+        if (interval.from != kTimeMin) {
+            CachedOffset previous = lookup(interval.from - 1, false);
+            time_t earlier = localSeconds - previous.offset;
+            if (earlier >= previous.from && earlier < interval.from) {
+                utc = earlier;
+            }
+        }
+        return utc;
+    }
+    const CachedOffset other =
+        lookup(utc < interval.from ? interval.from - 1 : interval.until, false);
+    time_t otherUtc = localSeconds - other.offset;
+    if (otherUtc >= other.from && otherUtc < other.until) {
+        return otherUtc;
+    }
+    // The local time does not exist, use the offset before the gap
+    return localSeconds - std::min(interval.offset, other.offset);
+}
+
+TimeZone::CachedOffset TimeZone::lookup(time_t utc, bool isCached) const {
+    CachedOffset cached = mCache.load();
+    if (utc < cached.from || utc >= cached.until) {
+        std::lock_guard<Mutex> lock(mWriterMutex);
+        cached = computeOffset(mRule, utc);
+        if (isCached) {
+            mCache.store(cached);
+        }
+    }
+    return cached;
+}
+
+bool TimeZone::parseRule(const char* text, TzRule* rule) {
+    *rule = {};
+    int32_t offset = 0;
+    text = parseName(text);
+    if (text) {
+        text = parseTime(text, kMaxOffsetHours, &offset);
+    }
+    if (text == nullptr) {
+        return false;
+    }
+    // POSIX offsets are positive west of Greenwich
+    rule->stdOffset = -offset;
+    if (*text == '\0') {
+        return true;
+    }
+
+    text = parseName(text);
+    if (text == nullptr) {
+        return false;
+    }
+    rule->hasDst = true;
+    rule->dstOffset = rule->stdOffset + kSecondsPerHour;
+    if (*text != ',' && *text != '\0') {
+        text = parseTime(text, kMaxOffsetHours, &offset);
+        if (text == nullptr) {
+            return false;
+        }
+        rule->dstOffset = -offset;
+    }
+    if (*text == '\0') {
+        text = kDefaultTransitions;
+    }
+    if (*text != ',') {
+        return false;
+    }
+    text = parseTransition(text + 1, &rule->start);
+    if (text == nullptr || *text != ',') {
+        return false;
+    }
+    text = parseTransition(text + 1, &rule->end);
+    return text != nullptr && *text == '\0';
+}
+
+TimeZone::CachedOffset TimeZone::computeOffset(const TzRule& rule,
+                                               time_t utc) {
+    if (!rule.hasDst) {
+        return {kTimeMin, kTimeMax, rule.stdOffset, false};
+    }
+    // The transitions of the previous, current and next year surround the
+    // time. A start is given in standard time, an end in daylight time.
+    int64_t localDays = (utc + rule.stdOffset) / kSecondsPerDay;
+    if ((utc + rule.stdOffset) % kSecondsPerDay < 0) {
+        localDays--;
+    }
+    const int32_t year = civilFromDays(localDays).year;
+    struct {
+        time_t instant;
+        bool isStart;
+    } transitions[6];
+    for (int i = 0; i < 3; i++) {
+        transitions[2 * i] = {
+            static_cast<time_t>(transitionDay(rule.start, year - 1 + i)) *
+                    kSecondsPerDay +
+                rule.start.time - rule.stdOffset,
+            true};
+        transitions[2 * i + 1] = {
+            static_cast<time_t>(transitionDay(rule.end, year - 1 + i)) *
+                    kSecondsPerDay +
+                rule.end.time - rule.dstOffset,
+            false};
+    }
+    // Insertion sort, the southern hemisphere ends the DST before it starts
+    for (size_t i = 1; i < std::size(transitions); i++) {
+        for (size_t j = i; j > 0 && transitions[j].instant <
+                                        transitions[j - 1].instant;
+             j--) {
+            std::swap(transitions[j], transitions[j - 1]);
+        }
+    }
+    size_t last = 0;
+    while (last + 1 < std::size(transitions) &&
+           transitions[last + 1].instant <= utc) {
+        last++;
+    }
+    const bool isDst = transitions[last].isStart;
+    const time_t end = last + 1 < std::size(transitions)
+                           ? transitions[last + 1].instant
+                           : kTimeMax;
+    return {transitions[last].instant, end,
+            isDst ? rule.dstOffset : rule.stdOffset, isDst};
+}
@@ -0,0 +1,201 @@
+/******************************************************************************
+ * File:    tz_database.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Implements TzDatabase class
+ ******************************************************************************/
+
+#include "tz_database.h"
+
+#include <algorithm>
+#include <cstring>
+#include <inttypes.h>
+
+#include "esp_log.h"
+
+// Embedded by target_add_binary_data() in CMakeLists.txt
+extern const uint8_t kZonesStart[] asm("_binary_zones_bin_start");
+extern const uint8_t kZonesEnd[] asm("_binary_zones_bin_end");
+
+static const char* kTag = "tz_database";
+static constexpr char kMagic[4] = {'T', 'Z', 'D', 'B'};
+static constexpr uint8_t kVersion = 1;
+static constexpr size_t kMaxNameLength = 63;
+
+/**
+ * @brief Header of the table, see tools/gen_zones.py
+ */
+struct TableHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t blockSize;
+    uint16_t zoneCount;
+    uint16_t blockCount;
+    uint16_t ruleCount;
+    uint32_t entriesOffset;
+    uint32_t rulesOffset;
+} __attribute__((packed));
+
+/**
+ * @brief Cursor decoding the prefix compressed entries one by one
+ */
+struct EntryCursor {
+    const uint8_t* next;
+    size_t index;
+    char name[kMaxNameLength + 1];
+    size_t nameLength;
+    uint8_t rule;
+};
+
+static bool readHeader(TableHeader* header) {
+    if (static_cast<size_t>(kZonesEnd - kZonesStart) < sizeof(TableHeader)) {
+        return false;
+    }
+    memcpy(header, kZonesStart, sizeof(TableHeader));
+    return memcmp(header->magic, kMagic, sizeof(kMagic)) == 0 &&
+           header->version == kVersion && header->blockSize > 0 &&
+           header->rulesOffset <= static_cast<size_t>(kZonesEnd - kZonesStart);
+}
+
+static uint16_t readU16(const uint8_t* data) {
+    return data[0] | (data[1] << 8);
+}
+
+static const uint8_t* blockStart(const TableHeader& header, size_t block) {
+    const uint8_t* offsets = kZonesStart + sizeof(TableHeader);
+    return kZonesStart + header.entriesOffset + readU16(&offsets[block * 2]);
+}
+
+static const char* ruleAt(const TableHeader& header, uint8_t rule) {
+    if (rule >= header.ruleCount) {
+        return nullptr;
+    }
+    const uint8_t* offsets =
+        kZonesStart + sizeof(TableHeader) + header.blockCount * 2;
+    return reinterpret_cast<const char*>(kZonesStart + header.rulesOffset +
+                                         readU16(&offsets[rule * 2]));
+}
+
+/**
+ * @brief Compare a key with a name which is not NUL terminated
+ */
+static int compareName(const std::string& key, const uint8_t* name,
+                       size_t nameLength) {
+    int result = memcmp(key.data(), name, std::min(key.size(), nameLength));
+    if (result != 0) {
+        return result;
+    }
+    return key.size() < nameLength ? -1 : key.size() > nameLength ? 1 : 0;
+}
+
+/**
+ * @brief Find the last block whose first name is not greater than the key
+ */
+static size_t findBlock(const TableHeader& header, const std::string& key) {
+    size_t low = 0;
+    size_t high = header.blockCount;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        // The first entry of a block stores the full name
+        const uint8_t* entry = blockStart(header, middle);
+        if (compareName(key, entry + 2, entry[1]) >= 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low == 0 ? 0 : low - 1;
+}
+
+static void seekBlock(const TableHeader& header, size_t block,
+                      EntryCursor* cursor) {
+    cursor->next = blockStart(header, block);
+    cursor->index = block * header.blockSize;
+    cursor->nameLength = 0;
+}
+
+static bool readEntry(const TableHeader& header, EntryCursor* cursor) {
+    if (cursor->index >= header.zoneCount) {
+        return false;
+    }
+    uint8_t shared = cursor->next[0];
+    uint8_t suffixLength = cursor->next[1];
+    if (shared > cursor->nameLength ||
+        shared + suffixLength > kMaxNameLength) {
+        return false;   // corrupted table
+    }
+    memcpy(&cursor->name[shared], &cursor->next[2], suffixLength);
+    cursor->nameLength = shared + suffixLength;
+    cursor->name[cursor->nameLength] = '\0';
+    cursor->rule = cursor->next[2 + suffixLength];
+    cursor->next += 3 + suffixLength;
+    cursor->index++;
+    return true;
+}
+
+bool TzDatabase::initialize() {
+    TableHeader header;
+    if (!readHeader(&header)) {
+        ESP_LOGE(kTag, "Time zone table is not valid");
+        return false;
+    }
+    ESP_LOGI(kTag, "%" PRIu16 " time zones, %" PRIu16 " rules, %u bytes",
+             header.zoneCount, header.ruleCount,
+             static_cast<unsigned>(kZonesEnd - kZonesStart));
+    return true;
+}
+
+const char* TzDatabase::findRule(const std::string& zone) {
+    TableHeader header;
+    if (!readHeader(&header) || header.blockCount == 0) {
+        return nullptr;
+    }
+    size_t block = findBlock(header, zone);
+    size_t end = (block + 1) * header.blockSize;
+    EntryCursor cursor;
+    seekBlock(header, block, &cursor);
+    while (cursor.index < end && readEntry(header, &cursor)) {
+        int result = zone.compare(cursor.name);
+        if (result == 0) {
+            return ruleAt(header, cursor.rule);
+        }
+        if (result < 0) {
+            break;   // names are sorted
+        }
+    }
+    return nullptr;
+}
+
+size_t TzDatabase::forEachZone(const std::string& prefix,
+                               ZoneCallback callback, void* arg) {
+    TableHeader header;
+    if (!readHeader(&header) || header.blockCount == 0) {
+        return 0;
+    }
+    size_t count = 0;
+    EntryCursor cursor;
+    seekBlock(header, findBlock(header, prefix), &cursor);
+    while (readEntry(header, &cursor)) {
+        int result = strncmp(cursor.name, prefix.c_str(), prefix.size());
+        if (result < 0) {
+            continue;
+        }
+        if (result > 0) {
+            break;   // past the last match
+        }
+        const char* rule = ruleAt(header, cursor.rule);
+        if (rule == nullptr) {
+            break;
+        }
+        count++;
+        if (!callback(cursor.name, rule, arg)) {
+            break;
+        }
+    }
+    return count;
+}
+
+size_t TzDatabase::getZoneCount() {
+    TableHeader header;
+    return readHeader(&header) ? header.zoneCount : 0;
+}
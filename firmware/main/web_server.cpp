@@ -7,6 +7,8 @@
 
 #include "web_server.h"
 
+#include <cctype>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 
@@ -15,17 +17,312 @@
 #include "esp_log.h"
 #include "esp_vfs.h"
 
+#include "tz_database.h"
 #include "wifi_info.h"
 
 static const char* kTag = "web_server";
 static char gScratch[10240];
+// Longest "name":"rule" pair written at once when streaming the zones
+static constexpr size_t kMaxZoneJsonLength = 160;
+static constexpr int kMinutesPerDay = 24 * 60;
+
+/**
+ * @brief State of the zone list streamed in chunks through gScratch
+ */
+struct ZoneWriter {
+    httpd_req_t* req;
+    size_t length;
+    bool isFirst;
+    esp_err_t err;
+};
+
+static bool flushZones(ZoneWriter* writer) {
+    if (writer->length > 0 && writer->err == ESP_OK) {
+        writer->err = httpd_resp_send_chunk(writer->req, gScratch,
+                                            writer->length);
+    }
+    writer->length = 0;
+    return writer->err == ESP_OK;
+}
+
+static bool writeZone(const char* name, const char* rule, void* arg) {
+    ZoneWriter* writer = static_cast<ZoneWriter*>(arg);
+    if (sizeof(gScratch) - writer->length < kMaxZoneJsonLength &&
+        !flushZones(writer)) {
+        return false;
+    }
+    // Names and rules contain no characters which need escaping
+    writer->length += snprintf(&gScratch[writer->length],
+                               sizeof(gScratch) - writer->length,
+                               "%s\"%s\":\"%s\"", writer->isFirst ? "" : ",",
+                               name, rule);
+    writer->isFirst = false;
+    return true;
+}
+
+/**
+ * @brief Decode a percent-encoded query value in place
+ */
+static void urlDecode(char* value) {
+    char* out = value;
+    for (const char* in = value; *in != '\0'; in++) {
+        if (*in == '%' && isxdigit(in[1]) && isxdigit(in[2])) {
+            char hex[3] = {in[1], in[2], '\0'};
+            *out++ = static_cast<char>(strtol(hex, nullptr, 16));
+            in += 2;
+        } else if (*in == '+') {
+            *out++ = ' ';
+        } else {
+            *out++ = *in;
+        }
+    }
+    *out = '\0';
+}
+
+/**
+ * @brief Receive the request body into gScratch as a string
+ *
+ * Responds with an error if the body can not be received.
+ *
+ * @return True if the body is received
+ */
+static bool receiveBody(httpd_req_t* req) {
+    if (req->content_len >= sizeof(gScratch)) {
+        /* Respond with 500 Internal Server Error */
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
+                            "content too long");
+        return false;
+    }
+    size_t length = 0;
+    while (length < req->content_len) {
+        int received = httpd_req_recv(req, gScratch + length,
+                                      req->content_len - length);
+        if (received <= 0) {
+            /* Respond with 500 Internal Server Error */
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
+                                "Failed to post control value");
+            return false;
+        }
+        length += received;
+    }
+    gScratch[length] = '\0';
+    return true;
+}
+
+/**
+ * @brief Send a JSON response and delete the JSON object
+ */
+static esp_err_t sendJson(httpd_req_t* req, cJSON* root) {
+    httpd_resp_set_type(req, "application/json");
+    char* jsonStr = cJSON_Print(root);
+    httpd_resp_sendstr(req, jsonStr);
+    free(static_cast<void*>(jsonStr));
+    cJSON_Delete(root);
+    return ESP_OK;
+}
+
+static cJSON* ledInfoToJson(const LedInfo& ledInfo) {
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "state",
+                            ledStateToString(ledInfo.getState()));
+    cJSON_AddNumberToObject(root, "R", ledInfo.getRed());
+    cJSON_AddNumberToObject(root, "G", ledInfo.getGreen());
+    cJSON_AddNumberToObject(root, "B", ledInfo.getBlue());
+    return root;
+}
+
+static cJSON* sleepInfoToJson(const SleepInfo& sleepInfo) {
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "sleep_before", sleepInfo.getSleepBefore());
+    cJSON_AddNumberToObject(root, "sleep_after", sleepInfo.getSleepAfter());
+    return root;
+}
+
+static cJSON* timeInfoToJson(const TimeInfo& timeInfo) {
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "tz_zone", timeInfo.getTzZone());
+    cJSON_AddStringToObject(root, "tz_offset", timeInfo.getTzOffset());
+    cJSON_AddStringToObject(root, "time_format",
+                            timeFormatToString(timeInfo.getTimeFormat()));
+    cJSON* ntpServers = cJSON_AddArrayToObject(root, "ntp_servers");
+    for (uint8_t i = 0; i < timeInfo.getNtpServerCount(); ++i) {
+        cJSON_AddItemToArray(ntpServers,
+                             cJSON_CreateString(timeInfo.getNtpServer(i)));
+    }
+    return root;
+}
+
+static cJSON* wifiInfoToJson(const WifiInfo& wifiInfo) {
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "hostname", wifiInfo.getHostname());
+    cJSON_AddStringToObject(root, "SSID", wifiInfo.getSSID());
+    cJSON_AddStringToObject(root, "auth_type",
+                            wifiAuthTypeToString(wifiInfo.getAuthType()));
+    return root;
+}
+
+/**
+ * @brief Get an integer field within the given range
+ *
+ * @return True if the field is a number within the range
+ */
+static bool getInt(const cJSON* json, const char* name, int min, int max,
+                   int* value) {
+    const cJSON* item = cJSON_GetObjectItem(json, name);
+    if (!cJSON_IsNumber(item) || item->valueint < min ||
+        item->valueint > max) {
+        return false;
+    }
+    *value = item->valueint;
+    return true;
+}
+
+/**
+ * @brief Update led info from JSON
+ *
+ * @return nullptr on success, otherwise the error message
+ */
+static const char* parseLedInfo(const cJSON* json, LedInfo& ledInfo) {
+    int red;
+    int green;
+    int blue;
+    if (!getInt(json, "R", 0, 255, &red) ||
+        !getInt(json, "G", 0, 255, &green) ||
+        !getInt(json, "B", 0, 255, &blue)) {
+        return "Invalid color";
+    }
+    ledInfo.setColor(red, green, blue);
+    const char* state =
+        cJSON_GetStringValue(cJSON_GetObjectItem(json, "state"));
+    if (state == nullptr) {
+        return "Unknown state";
+    } else if (strcmp(state, "on") == 0) {
+        ledInfo.setState(LedState::On);
+    } else if (strcmp(state, "off") == 0) {
+        ledInfo.setState(LedState::Off);
+    } else if (strcmp(state, "fade") == 0) {
+        ledInfo.setState(LedState::Fade);
+    } else if (strcmp(state, "pulse") == 0) {
+        ledInfo.setState(LedState::Pulse);
+    } else {
+        return "Unknown state";
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Update sleep info from JSON
+ *
+ * @return nullptr on success, otherwise the error message
+ */
+static const char* parseSleepInfo(const cJSON* json, SleepInfo& sleepInfo) {
+    int sleepBefore;
+    int sleepAfter;
+    if (!getInt(json, "sleep_before", 0, kMinutesPerDay - 1, &sleepBefore) ||
+        !getInt(json, "sleep_after", 0, kMinutesPerDay - 1, &sleepAfter)) {
+        return "Invalid sleep time";
+    }
+    sleepInfo.setSleepBefore(sleepBefore);
+    sleepInfo.setSleepAfter(sleepAfter);
+    return nullptr;
+}
+
+/**
+ * @brief Update time info from JSON, missing optional fields are kept
+ *
+ * @return nullptr on success, otherwise the error message
+ */
+static const char* parseTimeInfo(const cJSON* json, TimeInfo& timeInfo) {
+    // The rule of the zone comes from the time zone database, a rule sent
+    // by the client has to match it
+    const char* tzZone =
+        cJSON_GetStringValue(cJSON_GetObjectItem(json, "tz_zone"));
+    const char* tzRule = tzZone ? TzDatabase::findRule(tzZone) : nullptr;
+    if (tzRule == nullptr) {
+        return "Unknown time zone";
+    }
+    const char* tzOffset =
+        cJSON_GetStringValue(cJSON_GetObjectItem(json, "tz_offset"));
+    if (tzOffset && strcmp(tzOffset, tzRule) != 0) {
+        return "Time zone offset does not match the zone";
+    }
+    if (!timeInfo.setTzZone(tzZone) || !timeInfo.setTzOffset(tzRule)) {
+        return "Time zone too long";
+    }
+    const char* timeFormat =
+        cJSON_GetStringValue(cJSON_GetObjectItem(json, "time_format"));
+    if (timeFormat == nullptr) {
+        return "Unknown time format";
+    } else if (strcmp(timeFormat, "12h") == 0) {
+        timeInfo.setTimeFormat(TimeFormat::Hour12);
+    } else if (strcmp(timeFormat, "24h") == 0) {
+        timeInfo.setTimeFormat(TimeFormat::Hour24);
+    } else {
+        return "Unknown time format";
+    }
+    const cJSON* ntpServersJson = cJSON_GetObjectItem(json, "ntp_servers");
+    if (cJSON_IsArray(ntpServersJson)) {
+        // The servers are collected in a copy, so an invalid list keeps the
+        // old servers
+        TimeInfo serversInfo = timeInfo;
+        serversInfo.clearNtpServers();
+        const cJSON* server = nullptr;
+        cJSON_ArrayForEach(server, ntpServersJson) {
+            if (cJSON_IsString(server) && server->valuestring[0] != '\0' &&
+                !serversInfo.addNtpServer(server->valuestring)) {
+                return "Too many NTP servers or too long host name";
+            }
+        }
+        if (serversInfo.getNtpServerCount() == 0) {
+            return "No NTP server";
+        }
+        timeInfo = serversInfo;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Update wifi info from JSON, a missing password is kept
+ *
+ * @return nullptr on success, otherwise the error message
+ */
+static const char* parseWifiInfo(const cJSON* json, WifiInfo& wifiInfo) {
+    const char* hostname =
+        cJSON_GetStringValue(cJSON_GetObjectItem(json, "hostname"));
+    const char* ssid = cJSON_GetStringValue(cJSON_GetObjectItem(json, "SSID"));
+    if (hostname == nullptr || ssid == nullptr) {
+        return "Missing hostname or SSID";
+    }
+    if (!wifiInfo.setHostname(hostname) || !wifiInfo.setSSID(ssid)) {
+        return "Hostname or SSID too long";
+    }
+    const char* authType =
+        cJSON_GetStringValue(cJSON_GetObjectItem(json, "auth_type"));
+    if (authType == nullptr) {
+        return "Unknown wifi authentication type";
+    } else if (strcmp(authType, "open") == 0) {
+        wifiInfo.setAuthType(WifiAuthType::Open);
+    } else if (strcmp(authType, "wpa2") == 0) {
+        wifiInfo.setAuthType(WifiAuthType::WPA2);
+    } else if (strcmp(authType, "wpa3") == 0) {
+        wifiInfo.setAuthType(WifiAuthType::WPA3);
+    } else {
+        return "Unknown wifi authentication type";
+    }
+    const char* password =
+        cJSON_GetStringValue(cJSON_GetObjectItem(json, "password"));
+    if (password != nullptr && !wifiInfo.setPassword(password)) {
+        return "Password too long";
+    }
+    return nullptr;
+}
 
 WebServer::WebServer(IClock& callback) : mCallback(callback) {}
 
 void WebServer::initialize() {
     httpd_handle_t server = NULL;
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
-    config.max_uri_handlers = 9;
+    config.max_uri_handlers = 15;
     config.uri_match_fn = httpd_uri_match_wildcard;
 
     if (httpd_start(&server, &config) != ESP_OK) {
@@ -68,6 +365,42 @@ void WebServer::initialize() {
                                    .user_ctx = &mCallback};
     httpd_register_uri_handler(server, &timeInfoPostUri);
 
+    httpd_uri_t syncStatusGetUri = {.uri = "/api/v1/clock/sync_status",
+                                    .method = HTTP_GET,
+                                    .handler = handleGetSyncStatus,
+                                    .user_ctx = &mCallback};
+    httpd_register_uri_handler(server, &syncStatusGetUri);
+
+    httpd_uri_t temperatureGetUri = {.uri = "/api/v1/clock/temperature",
+                                     .method = HTTP_GET,
+                                     .handler = handleGetTemperature,
+                                     .user_ctx = &mCallback};
+    httpd_register_uri_handler(server, &temperatureGetUri);
+
+    httpd_uri_t zonesGetUri = {.uri = "/api/v1/clock/zones",
+                               .method = HTTP_GET,
+                               .handler = handleGetZones,
+                               .user_ctx = &mCallback};
+    httpd_register_uri_handler(server, &zonesGetUri);
+
+    httpd_uri_t configGetUri = {.uri = "/api/v1/config",
+                                .method = HTTP_GET,
+                                .handler = handleGetConfig,
+                                .user_ctx = &mCallback};
+    httpd_register_uri_handler(server, &configGetUri);
+
+    httpd_uri_t configPostUri = {.uri = "/api/v1/config",
+                                 .method = HTTP_POST,
+                                 .handler = handleSetConfig,
+                                 .user_ctx = &mCallback};
+    httpd_register_uri_handler(server, &configPostUri);
+
+    httpd_uri_t configStatsGetUri = {.uri = "/api/v1/config/stats",
+                                     .method = HTTP_GET,
+                                     .handler = handleGetConfigStats,
+                                     .user_ctx = &mCallback};
+    httpd_register_uri_handler(server, &configStatsGetUri);
+
     httpd_uri_t wifiInfoGetUri = {.uri = "/api/v1/wifi/wifi_info",
                                   .method = HTTP_GET,
                                   .handler = handleGetWifiInfo,
@@ -142,65 +475,23 @@ esp_err_t WebServer::handleGetLedInfo(httpd_req_t* req) {
                             "Failed to get LedInfo");
         return ESP_FAIL;
     }
-    auto ledInfo = maybeWLedInfo.value();
-    httpd_resp_set_type(req, "application/json");
-    cJSON* root = cJSON_CreateObject();
-    cJSON_AddStringToObject(root, "state",
-                            ledStateToString(ledInfo.getState()));
-    cJSON_AddNumberToObject(root, "R", ledInfo.getRed());
-    cJSON_AddNumberToObject(root, "G", ledInfo.getGreen());
-    cJSON_AddNumberToObject(root, "B", ledInfo.getBlue());
-    char* jsonStr = cJSON_Print(root);
-    httpd_resp_sendstr(req, jsonStr);
-    free(static_cast<void*>(jsonStr));
-    cJSON_Delete(root);
-    return ESP_OK;
+    return sendJson(req, ledInfoToJson(maybeWLedInfo.value()));
 }
 
 esp_err_t WebServer::handleSetLedInfo(httpd_req_t* req) {
     IClock* callback = static_cast<IClock*>(req->user_ctx);
-    int cur_len = 0;
-    int received = 0;
-    if (req->content_len >= sizeof(gScratch)) {
-        /* Respond with 500 Internal Server Error */
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
-                            "content too long");
+    if (!receiveBody(req)) {
         return ESP_FAIL;
     }
-    while (cur_len < req->content_len) {
-        received = httpd_req_recv(req, gScratch + cur_len, req->content_len);
-        if (received <= 0) {
-            /* Respond with 500 Internal Server Error */
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
-                                "Failed to post control value");
-            return ESP_FAIL;
-        }
-        cur_len += received;
-    }
-    gScratch[req->content_len] = '\0';
     cJSON* root = cJSON_Parse(gScratch);
     LedInfo ledInfo;
-    // ledInfo.setState(cJSON_GetObjectItem(root, "hostname")->valuestring);
-    ledInfo.setRed(cJSON_GetObjectItem(root, "R")->valueint);
-    ledInfo.setGreen(cJSON_GetObjectItem(root, "G")->valueint);
-    ledInfo.setBlue(cJSON_GetObjectItem(root, "B")->valueint);
-    std::string state =
-        cJSON_GetObjectItemCaseSensitive(root, "state")->valuestring;
-    if (state == "on") {
-        ledInfo.setState(LedState::On);
-    } else if (state == "off") {
-        ledInfo.setState(LedState::Off);
-    } else if (state == "fade") {
-        ledInfo.setState(LedState::Fade);
-    } else if (state == "pulse") {
-        ledInfo.setState(LedState::Pulse);
-    } else {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
-                            "Unknown state");
+    const char* error = parseLedInfo(root, ledInfo);
+    cJSON_Delete(root);
+    if (error != nullptr) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, error);
         return ESP_FAIL;
     }
     callback->onSetLedInfo(ledInfo);
-    cJSON_Delete(root);
     httpd_resp_sendstr(req, "Post control value successfully");
     return ESP_OK;
 }
@@ -213,46 +504,23 @@ esp_err_t WebServer::handleGetSleepInfo(httpd_req_t* req) {
                             "Failed to get SleepInfo");
         return ESP_FAIL;
     }
-    auto sleepInfo = maybeSleepInfo.value();
-    httpd_resp_set_type(req, "application/json");
-    cJSON* root = cJSON_CreateObject();
-    cJSON_AddNumberToObject(root, "sleep_before", sleepInfo.getSleepBefore());
-    cJSON_AddNumberToObject(root, "sleep_after", sleepInfo.getSleepAfter());
-    char* jsonStr = cJSON_Print(root);
-    httpd_resp_sendstr(req, jsonStr);
-    free(static_cast<void*>(jsonStr));
-    cJSON_Delete(root);
-    return ESP_OK;
+    return sendJson(req, sleepInfoToJson(maybeSleepInfo.value()));
 }
 
 esp_err_t WebServer::handleSetSleepInfo(httpd_req_t* req) {
     IClock* callback = static_cast<IClock*>(req->user_ctx);
-    int cur_len = 0;
-    int received = 0;
-    if (req->content_len >= sizeof(gScratch)) {
-        /* Respond with 500 Internal Server Error */
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
-                            "content too long");
+    if (!receiveBody(req)) {
         return ESP_FAIL;
     }
-    while (cur_len < req->content_len) {
-        received = httpd_req_recv(req, gScratch + cur_len, req->content_len);
-        if (received <= 0) {
-            /* Respond with 500 Internal Server Error */
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
-                                "Failed to post control value");
-            return ESP_FAIL;
-        }
-        cur_len += received;
-    }
-    gScratch[req->content_len] = '\0';
     cJSON* root = cJSON_Parse(gScratch);
     SleepInfo sleepInfo;
-    sleepInfo.setSleepBefore(
-        cJSON_GetObjectItem(root, "sleep_before")->valueint);
-    sleepInfo.setSleepAfter(cJSON_GetObjectItem(root, "sleep_after")->valueint);
-    callback->onSetSleepInfo(sleepInfo);
+    const char* error = parseSleepInfo(root, sleepInfo);
     cJSON_Delete(root);
+    if (error != nullptr) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, error);
+        return ESP_FAIL;
+    }
+    callback->onSetSleepInfo(sleepInfo);
     httpd_resp_sendstr(req, "Post control value successfully");
     return ESP_OK;
 }
@@ -265,62 +533,115 @@ esp_err_t WebServer::handleGetTimeInfo(httpd_req_t* req) {
                             "Failed to get SleepInfo");
         return ESP_FAIL;
     }
-    auto timeInfo = maybeTimeInfo.value();
-    httpd_resp_set_type(req, "application/json");
-    cJSON* root = cJSON_CreateObject();
-    cJSON_AddStringToObject(root, "tz_zone", timeInfo.getTzZone().c_str());
-    cJSON_AddStringToObject(root, "tz_offset", timeInfo.getTzOffset().c_str());
-    cJSON_AddStringToObject(root, "time_format",
-                            timeFormatToString(timeInfo.getTimeFormat()));
-    char* jsonStr = cJSON_Print(root);
-    httpd_resp_sendstr(req, jsonStr);
-    free(static_cast<void*>(jsonStr));
-    cJSON_Delete(root);
-    return ESP_OK;
+    return sendJson(req, timeInfoToJson(maybeTimeInfo.value()));
 }
 
 esp_err_t WebServer::handleSetTimeInfo(httpd_req_t* req) {
     IClock* callback = static_cast<IClock*>(req->user_ctx);
-    int cur_len = 0;
-    int received = 0;
-    if (req->content_len >= sizeof(gScratch)) {
-        /* Respond with 500 Internal Server Error */
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
-                            "content too long");
+    if (!receiveBody(req)) {
         return ESP_FAIL;
     }
-    while (cur_len < req->content_len) {
-        received = httpd_req_recv(req, gScratch + cur_len, req->content_len);
-        if (received <= 0) {
-            /* Respond with 500 Internal Server Error */
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
-                                "Failed to post control value");
-            return ESP_FAIL;
-        }
-        cur_len += received;
-    }
-    gScratch[req->content_len] = '\0';
     cJSON* root = cJSON_Parse(gScratch);
-    TimeInfo timeInfo;
-    timeInfo.setTzZone(cJSON_GetObjectItem(root, "tz_zone")->valuestring);
-    timeInfo.setTzOffset(cJSON_GetObjectItem(root, "tz_offset")->valuestring);
-    std::string timeFormat =
-        cJSON_GetObjectItemCaseSensitive(root, "time_format")->valuestring;
-    if (timeFormat == "12h") {
-        timeInfo.setTimeFormat(TimeFormat::Hour12);
-    } else if (timeFormat == "24h") {
-        timeInfo.setTimeFormat(TimeFormat::Hour24);
-    } else {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
-                            "Unknown time format");
+    // fields missing in the request keep their current value
+    TimeInfo timeInfo = callback->onGetTimeInfo().value_or(TimeInfo());
+    const char* error = parseTimeInfo(root, timeInfo);
+    cJSON_Delete(root);
+    if (error != nullptr) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, error);
         return ESP_FAIL;
     }
     callback->onSetTimeInfo(timeInfo);
-    cJSON_Delete(root);
     httpd_resp_sendstr(req, "Post control value successfully");
     return ESP_OK;
 }
 
+esp_err_t WebServer::handleGetSyncStatus(httpd_req_t* req) {
+    IClock* callback = static_cast<IClock*>(req->user_ctx);
+    SyncStatus status = callback->onGetSyncStatus();
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddBoolToObject(root, "synced", status.isSynced);
+    cJSON_AddNumberToObject(root, "sync_count", status.syncCount);
+    cJSON_AddNumberToObject(root, "last_sync", status.lastSync);
+    cJSON_AddNumberToObject(root, "last_offset_us", status.lastOffsetUs);
+    cJSON_AddStringToObject(root, "last_correction",
+                            status.wasStepped ? "step" : "slew");
+    cJSON_AddNumberToObject(root, "sync_interval", status.syncInterval / 1000);
+    cJSON* servers = cJSON_AddArrayToObject(root, "servers");
+    for (const NtpServerStatus& server : status.servers) {
+        cJSON* serverJson = cJSON_CreateObject();
+        cJSON_AddStringToObject(serverJson, "name", server.name.c_str());
+        cJSON_AddNumberToObject(serverJson, "rtt_ms", server.rttMs);
+        cJSON_AddItemToArray(servers, serverJson);
+    }
+    cJSON_AddNumberToObject(root, "rtc_drift_ppb", status.rtcDriftPpb);
+    cJSON_AddNumberToObject(root, "rtc_aging_offset", status.rtcAgingOffset);
+    return sendJson(req, root);
+}
+
+esp_err_t WebServer::handleGetTemperature(httpd_req_t* req) {
+    IClock* callback = static_cast<IClock*>(req->user_ctx);
+    // Optional ?points=N requests a series downsampled to N points
+    size_t points = 0;
+    char query[32];
+    char value[8];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "points", value, sizeof(value)) ==
+            ESP_OK) {
+        points = strtoul(value, nullptr, 10);
+    }
+    TemperatureStats stats = callback->onGetTemperatureStats(points);
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "sample_count", stats.sampleCount);
+    cJSON_AddNumberToObject(root, "sample_interval", stats.sampleInterval);
+    if (stats.sampleCount > 0) {
+        cJSON_AddNumberToObject(root, "current", stats.current);
+        cJSON_AddNumberToObject(root, "min", stats.min);
+        cJSON_AddNumberToObject(root, "max", stats.max);
+        cJSON_AddNumberToObject(root, "average", stats.average);
+    }
+    cJSON* series = cJSON_AddArrayToObject(root, "series");
+    for (float temperature : stats.series) {
+        cJSON_AddItemToArray(series, cJSON_CreateNumber(temperature));
+    }
+    return sendJson(req, root);
+}
+
+esp_err_t WebServer::handleGetZones(httpd_req_t* req) {
+    // Optional ?prefix=Europe/ limits the list, the response is an object
+    // of zone names and POSIX TZ rules
+    char query[96];
+    char prefix[64] = "";
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "prefix", prefix, sizeof(prefix)) ==
+            ESP_OK) {
+        urlDecode(prefix);
+    }
+    httpd_resp_set_type(req, "application/json");
+    ZoneWriter writer = {req, 0, true, ESP_OK};
+    gScratch[writer.length++] = '{';
+    TzDatabase::forEachZone(prefix, writeZone, &writer);
+    gScratch[writer.length++] = '}';
+    if (!flushZones(&writer)) {
+        ESP_LOGE(kTag, "Failed to send zones");
+        httpd_resp_send_chunk(req, nullptr, 0);
+        return ESP_FAIL;
+    }
+    httpd_resp_send_chunk(req, nullptr, 0);
+    return ESP_OK;
+}
+
+esp_err_t WebServer::handleGetConfigStats(httpd_req_t* req) {
+    IClock* callback = static_cast<IClock*>(req->user_ctx);
+    ConfigStoreStats stats = callback->onGetConfigStoreStats();
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "save_count", stats.saveCount);
+    cJSON_AddNumberToObject(root, "write_count", stats.writeCount);
+    cJSON_AddNumberToObject(root, "coalesced_count", stats.coalescedCount);
+    cJSON_AddNumberToObject(root, "failed_count", stats.failedCount);
+    cJSON_AddNumberToObject(root, "pending_count", stats.pendingCount);
+    return sendJson(req, root);
+}
+
 esp_err_t WebServer::handleGetWifiInfo(httpd_req_t* req) {
     IClock* callback = static_cast<IClock*>(req->user_ctx);
     auto maybeWifiInfo = callback->onGetWifiInfo();
@@ -329,63 +650,98 @@ esp_err_t WebServer::handleGetWifiInfo(httpd_req_t* req) {
                             "Failed to get WifiInfo");
         return ESP_FAIL;
     }
-    auto wifiInfo = maybeWifiInfo.value();
-    httpd_resp_set_type(req, "application/json");
-    cJSON* root = cJSON_CreateObject();
-    cJSON_AddStringToObject(root, "hostname", wifiInfo.getHostname().c_str());
-    cJSON_AddStringToObject(root, "SSID", wifiInfo.getSSID().c_str());
-    cJSON_AddStringToObject(root, "auth_type",
-                            wifiAuthTypeToString(wifiInfo.getAuthType()));
+    cJSON* root = wifiInfoToJson(maybeWifiInfo.value());
     // do not share the actual password
     cJSON_AddStringToObject(root, "password", "");
-    char* jsonStr = cJSON_Print(root);
-    httpd_resp_sendstr(req, jsonStr);
-    free(static_cast<void*>(jsonStr));
-    cJSON_Delete(root);
-    return ESP_OK;
+    return sendJson(req, root);
 }
 
 esp_err_t WebServer::handleSetWifiInfo(httpd_req_t* req) {
     IClock* callback = static_cast<IClock*>(req->user_ctx);
-    int cur_len = 0;
-    int received = 0;
-    if (req->content_len >= sizeof(gScratch)) {
-        /* Respond with 500 Internal Server Error */
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
-                            "content too long");
+    if (!receiveBody(req)) {
         return ESP_FAIL;
     }
-    while (cur_len < req->content_len) {
-        received = httpd_req_recv(req, gScratch + cur_len, req->content_len);
-        if (received <= 0) {
-            /* Respond with 500 Internal Server Error */
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
-                                "Failed to post control value");
-            return ESP_FAIL;
-        }
-        cur_len += received;
+    cJSON* root = cJSON_Parse(gScratch);
+    WifiInfo wifiInfo = callback->onGetWifiInfo().value_or(WifiInfo());
+    const char* error = parseWifiInfo(root, wifiInfo);
+    cJSON_Delete(root);
+    if (error != nullptr) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, error);
+        return ESP_FAIL;
+    }
+    callback->onSetWifiInfo(wifiInfo);
+    httpd_resp_sendstr(req, "Post control value successfully");
+    return ESP_OK;
+}
+
+esp_err_t WebServer::handleGetConfig(httpd_req_t* req) {
+    IClock* callback = static_cast<IClock*>(req->user_ctx);
+    DeviceConfig config = callback->onGetConfig();
+    cJSON* root = cJSON_CreateObject();
+    if (config.ledInfo.has_value()) {
+        cJSON_AddItemToObject(root, "led_info",
+                              ledInfoToJson(*config.ledInfo));
+    }
+    if (config.sleepInfo.has_value()) {
+        cJSON_AddItemToObject(root, "sleep_info",
+                              sleepInfoToJson(*config.sleepInfo));
+    }
+    if (config.timeInfo.has_value()) {
+        cJSON_AddItemToObject(root, "time_info",
+                              timeInfoToJson(*config.timeInfo));
+    }
+    // without the password, a posted copy keeps the current one
+    if (config.wifiInfo.has_value()) {
+        cJSON_AddItemToObject(root, "wifi_info",
+                              wifiInfoToJson(*config.wifiInfo));
+    }
+    return sendJson(req, root);
+}
+
+esp_err_t WebServer::handleSetConfig(httpd_req_t* req) {
+    IClock* callback = static_cast<IClock*>(req->user_ctx);
+    if (!receiveBody(req)) {
+        return ESP_FAIL;
     }
-    gScratch[req->content_len] = '\0';
     cJSON* root = cJSON_Parse(gScratch);
-    WifiInfo wifiInfo;
-    wifiInfo.setHostname(cJSON_GetObjectItem(root, "hostname")->valuestring);
-    wifiInfo.setSSID(cJSON_GetObjectItem(root, "SSID")->valuestring);
-    std::string authType =
-        cJSON_GetObjectItemCaseSensitive(root, "auth_type")->valuestring;
-    if (authType == "open") {
-        wifiInfo.setAuthType(WifiAuthType::Open);
-    } else if (authType == "wpa2") {
-        wifiInfo.setAuthType(WifiAuthType::WPA2);
-    } else if (authType == "wpa3") {
-        wifiInfo.setAuthType(WifiAuthType::WPA3);
-    } else {
+    if (!cJSON_IsObject(root)) {
+        cJSON_Delete(root);
         httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
-                            "Unknown wifi authentication type");
+                            "Invalid config");
         return ESP_FAIL;
     }
-    wifiInfo.setPassword(cJSON_GetObjectItem(root, "password")->valuestring);
-    callback->onSetWifiInfo(wifiInfo);
+    // Every section is validated before any of them is applied, the
+    // sections missing in the request keep their current value
+    DeviceConfig current = callback->onGetConfig();
+    DeviceConfig config;
+    const char* error = nullptr;
+    const cJSON* json = cJSON_GetObjectItem(root, "led_info");
+    if (json != nullptr && error == nullptr) {
+        config.ledInfo = current.ledInfo.value_or(LedInfo());
+        error = parseLedInfo(json, *config.ledInfo);
+    }
+    json = cJSON_GetObjectItem(root, "sleep_info");
+    if (json != nullptr && error == nullptr) {
+        config.sleepInfo = current.sleepInfo.value_or(SleepInfo());
+        error = parseSleepInfo(json, *config.sleepInfo);
+    }
+    json = cJSON_GetObjectItem(root, "time_info");
+    if (json != nullptr && error == nullptr) {
+        config.timeInfo = current.timeInfo.value_or(TimeInfo());
+        error = parseTimeInfo(json, *config.timeInfo);
+    }
+    json = cJSON_GetObjectItem(root, "wifi_info");
+    if (json != nullptr && error == nullptr) {
+        config.wifiInfo = current.wifiInfo.value_or(WifiInfo());
+        error = parseWifiInfo(json, *config.wifiInfo);
+    }
     cJSON_Delete(root);
+    if (error != nullptr) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, error);
+        return ESP_FAIL;
+    }
+    // A changed wifi config restarts the clock, the response is sent first
     httpd_resp_sendstr(req, "Post control value successfully");
+    callback->onSetConfig(config);
     return ESP_OK;
-}
\ No newline at end of file
+}
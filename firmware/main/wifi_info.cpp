@@ -7,23 +7,48 @@
 
 #include "wifi_info.h"
 
-WifiInfo::WifiInfo(const std::string& hostname, const std::string& ssid,
-                   const WifiAuthType& authType, const std::string& password)
-    : mHostname(hostname), mSsid(ssid), mAuthType(authType),
-      mPassword(password) {}
-
-std::string WifiInfo::getHostname() const { return mHostname; }
-
-void WifiInfo::setHostname(const std::string& value) { mHostname = value; }
-
-std::string WifiInfo::getSSID() const { return mSsid; }
-
-void WifiInfo::setSSID(const std::string& value) { mSsid = value; }
+#include <cstring>
+
+/**
+ * @brief Copy a string into a fixed-size buffer
+ *
+ * @return False if the string does not fit, the buffer is left unchanged
+ */
+static bool copyString(char* buffer, size_t size, const char* value) {
+    size_t length = strlen(value);
+    if (length >= size) {
+        return false;
+    }
+    memcpy(buffer, value, length + 1);
+    return true;
+}
+
+WifiInfo::WifiInfo(const char* hostname, const char* ssid,
+                   const WifiAuthType& authType, const char* password)
+    : mAuthType(authType) {
+    setHostname(hostname);
+    setSSID(ssid);
+    setPassword(password);
+}
+
+const char* WifiInfo::getHostname() const { return mHostname; }
+
+bool WifiInfo::setHostname(const char* value) {
+    return copyString(mHostname, sizeof(mHostname), value);
+}
+
+const char* WifiInfo::getSSID() const { return mSsid; }
+
+bool WifiInfo::setSSID(const char* value) {
+    return copyString(mSsid, sizeof(mSsid), value);
+}
 
 WifiAuthType WifiInfo::getAuthType() const { return mAuthType; }
 
 void WifiInfo::setAuthType(const WifiAuthType& value) { mAuthType = value; }
 
-std::string WifiInfo::getPassword() const { return mPassword; }
+const char* WifiInfo::getPassword() const { return mPassword; }
 
-void WifiInfo::setPassword(const std::string& value) { mPassword = value; }
\ No newline at end of file
+bool WifiInfo::setPassword(const char* value) {
+    return copyString(mPassword, sizeof(mPassword), value);
+}
\ No newline at end of file
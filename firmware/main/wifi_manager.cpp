@@ -67,8 +67,7 @@ void WifiManager::eventHandler(esp_event_base_t eventBase, int32_t eventId,
 
 bool WifiManager::connectSta(const WifiInfo& wifiInfo) {
     esp_netif_t* netif = esp_netif_create_default_wifi_sta();
-    ESP_ERROR_CHECK(
-        esp_netif_set_hostname(netif, wifiInfo.getHostname().c_str()));
+    ESP_ERROR_CHECK(esp_netif_set_hostname(netif, wifiInfo.getHostname()));
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
@@ -82,12 +81,12 @@ bool WifiManager::connectSta(const WifiInfo& wifiInfo) {
 
     wifi_config_t wifiConfig = {};
     std::strncpy(reinterpret_cast<char*>(wifiConfig.sta.ssid),
-                 wifiInfo.getSSID().c_str(), sizeof(wifiConfig.sta.ssid));
+                 wifiInfo.getSSID(), sizeof(wifiConfig.sta.ssid));
     unsigned char password[64];
     size_t passwordLenght;
     mbedtls_base64_decode(password, 64, &passwordLenght,
-                          (unsigned char*) wifiInfo.getPassword().c_str(),
-                          wifiInfo.getPassword().length());
+                          (unsigned char*) wifiInfo.getPassword(),
+                          std::strlen(wifiInfo.getPassword()));
     password[passwordLenght] = '\0';
     std::strncpy(reinterpret_cast<char*>(wifiConfig.sta.password),
                  reinterpret_cast<char*>(password),
@@ -109,13 +108,16 @@ bool WifiManager::connectSta(const WifiInfo& wifiInfo) {
     ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
     ESP_ERROR_CHECK(esp_wifi_set_config(WIFI_IF_STA, &wifiConfig));
     ESP_ERROR_CHECK(esp_wifi_start());
+    // The radio wakes up for the beacons only, the web server stays
+    // reachable while the chip is in light sleep
+    ESP_ERROR_CHECK(esp_wifi_set_ps(WIFI_PS_MIN_MODEM));
 
     EventBits_t bits =
         xEventGroupWaitBits(mWifiEventGroup, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT,
                             pdFALSE, pdFALSE, pdMS_TO_TICKS(10000));
 
     if (bits & WIFI_CONNECTED_BIT) {
-        ESP_LOGI(kTag, "Connected to STA: %s", wifiInfo.getSSID().c_str());
+        ESP_LOGI(kTag, "Connected to STA: %s", wifiInfo.getSSID());
         mMode = WifiManager::Mode::Sta;
         return true;
     }
@@ -126,16 +128,15 @@ bool WifiManager::connectSta(const WifiInfo& wifiInfo) {
 
 void WifiManager::startAp(const WifiInfo& wifiInfo) {
     esp_netif_t* netif = esp_netif_create_default_wifi_ap();
-    ESP_ERROR_CHECK(
-        esp_netif_set_hostname(netif, wifiInfo.getHostname().c_str()));
+    ESP_ERROR_CHECK(esp_netif_set_hostname(netif, wifiInfo.getHostname()));
 
     wifi_init_config_t cfg = WIFI_INIT_CONFIG_DEFAULT();
     ESP_ERROR_CHECK(esp_wifi_init(&cfg));
 
     wifi_config_t wifiConfig = {};
     std::strncpy(reinterpret_cast<char*>(wifiConfig.ap.ssid),
-                 wifiInfo.getSSID().c_str(), sizeof(wifiConfig.ap.ssid));
-    wifiConfig.ap.ssid_len = wifiInfo.getSSID().length();
+                 wifiInfo.getSSID(), sizeof(wifiConfig.ap.ssid));
+    wifiConfig.ap.ssid_len = std::strlen(wifiInfo.getSSID());
     wifiConfig.ap.channel = 1;
     wifiConfig.ap.max_connection = 4;
     wifiConfig.ap.authmode = WIFI_AUTH_OPEN;
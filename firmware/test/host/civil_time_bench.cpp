@@ -0,0 +1,97 @@
+/******************************************************************************
+ * File:    civil_time_bench.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Benchmarks the civil date arithmetic against glibc
+ ******************************************************************************/
+
+#include <ctime>
+#include <inttypes.h>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "civil_time.h"
+
+// 2025-01-01 00:00:00 UTC, the benchmarks walk about a day per iteration
+static constexpr time_t kStartTime = 1735689600;
+static constexpr time_t kStep = 86400 + 3607;
+
+static void BM_DaysFromCivil(benchmark::State& state) {
+    uint32_t day = 0;
+    for (auto _ : state) {
+        day = day % 28 + 1;
+        benchmark::DoNotOptimize(daysFromCivil(2025, day % 12 + 1, day));
+    }
+}
+BENCHMARK(BM_DaysFromCivil);
+
+static void BM_CivilFromDays(benchmark::State& state) {
+    int32_t days = kStartTime / 86400;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(civilFromDays(days++));
+    }
+}
+BENCHMARK(BM_CivilFromDays);
+
+static void BM_GmtimeUtc(benchmark::State& state) {
+    time_t time = kStartTime;
+    struct tm tm;
+    for (auto _ : state) {
+        gmtimeUtc(time, &tm);
+        benchmark::DoNotOptimize(tm);
+        time += kStep;
+    }
+}
+BENCHMARK(BM_GmtimeUtc);
+
+static void BM_GmtimeLibc(benchmark::State& state) {
+    time_t time = kStartTime;
+    struct tm tm;
+    for (auto _ : state) {
+        gmtime_r(&time, &tm);
+        benchmark::DoNotOptimize(tm);
+        time += kStep;
+    }
+}
+BENCHMARK(BM_GmtimeLibc);
+
+/**
+ * @brief Broken down times of consecutive steps, inputs of the timegm runs
+ */
+static const std::vector<struct tm>& getTimes() {
+    static std::vector<struct tm> times = []() {
+        std::vector<struct tm> result(1024);
+        time_t time = kStartTime;
+        for (struct tm& tm : result) {
+            gmtime_r(&time, &tm);
+            time += kStep;
+        }
+        return result;
+    }();
+    return times;
+}
+
+static void BM_TimegmUtc(benchmark::State& state) {
+    const std::vector<struct tm>& times = getTimes();
+    size_t index = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(timegmUtc(times[index]));
+        index = (index + 1) % times.size();
+    }
+}
+BENCHMARK(BM_TimegmUtc);
+
+static void BM_TimegmLibc(benchmark::State& state) {
+    const std::vector<struct tm>& times = getTimes();
+    size_t index = 0;
+    for (auto _ : state) {
+        // timegm() normalizes its argument
+        struct tm tm = times[index];
+        benchmark::DoNotOptimize(timegm(&tm));
+        index = (index + 1) % times.size();
+    }
+}
+BENCHMARK(BM_TimegmLibc);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,61 @@
+/******************************************************************************
+ * File:    civil_time_test.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Compares the civil date arithmetic with glibc
+ ******************************************************************************/
+
+#include <ctime>
+#include <inttypes.h>
+
+#include <gtest/gtest.h>
+
+#include "civil_time.h"
+
+// about +-2190 years around the epoch
+static constexpr int32_t kDayRange = 800000;
+
+TEST(CivilTimeTest, MatchesGmtimeAndTimegm) {
+    for (int32_t days = -kDayRange; days <= kDayRange; ++days) {
+        // walk through the day as well, negative times included
+        const int64_t secondOfDay = (static_cast<int64_t>(days) * 7919) % 86400;
+        const time_t time = static_cast<time_t>(days) * 86400 +
+                            (secondOfDay < 0 ? secondOfDay + 86400
+                                             : secondOfDay);
+        struct tm expected = {};
+        ASSERT_NE(gmtime_r(&time, &expected), nullptr);
+
+        struct tm actual = {};
+        gmtimeUtc(time, &actual);
+        ASSERT_EQ(actual.tm_year, expected.tm_year) << "time " << time;
+        ASSERT_EQ(actual.tm_mon, expected.tm_mon) << "time " << time;
+        ASSERT_EQ(actual.tm_mday, expected.tm_mday) << "time " << time;
+        ASSERT_EQ(actual.tm_hour, expected.tm_hour) << "time " << time;
+        ASSERT_EQ(actual.tm_min, expected.tm_min) << "time " << time;
+        ASSERT_EQ(actual.tm_sec, expected.tm_sec) << "time " << time;
+        ASSERT_EQ(actual.tm_wday, expected.tm_wday) << "time " << time;
+        ASSERT_EQ(actual.tm_yday, expected.tm_yday) << "time " << time;
+        ASSERT_EQ(actual.tm_isdst, 0);
+
+        ASSERT_EQ(timegmUtc(expected), time);
+        struct tm copy = expected;
+        ASSERT_EQ(timegm(&copy), time);
+
+        const CivilDate date = civilFromDays(days);
+        ASSERT_EQ(date.year, expected.tm_year + 1900) << "days " << days;
+        ASSERT_EQ(date.month, static_cast<uint32_t>(expected.tm_mon + 1));
+        ASSERT_EQ(date.day, static_cast<uint32_t>(expected.tm_mday));
+        ASSERT_EQ(daysFromCivil(date.year, date.month, date.day), days);
+        ASSERT_EQ(weekdayFromDays(days),
+                  static_cast<uint32_t>(expected.tm_wday));
+    }
+}
+
+TEST(CivilTimeTest, BcdRoundTrip) {
+    for (uint8_t value = 0; value < 100; ++value) {
+        const uint8_t bcd = decToBcd(value);
+        EXPECT_EQ(bcd >> 4, value / 10);
+        EXPECT_EQ(bcd & 0x0F, value % 10);
+        EXPECT_EQ(bcdToDec(bcd), value);
+    }
+}
@@ -0,0 +1,544 @@
+/******************************************************************************
+ * File:    config_record_bench.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Benchmarks loading config records against the JSON config files
+ ******************************************************************************/
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "config_record.h"
+#include "esp_rom_crc.h"
+#include "led_info.h"
+#include "sleep_info.h"
+#include "time_info.h"
+#include "wifi_info.h"
+
+#if defined(HAVE_CJSON)
+#include "cJSON.h"
+#elif defined(HAVE_JSONCPP)
+#include <json/json.h>
+#endif
+
+// all sections are at payload layout version 1
+static constexpr uint16_t kVersion = 1;
+
+// The defaults of flash_data/config, CONFIG_DIR is set by CMake
+static const LedInfo kLedInfo(0, 255, 0, LedState::Fade);
+static const SleepInfo kSleepInfo(480, 1380);
+static const WifiInfo kWifiInfo("mynixieclock", "", WifiAuthType::Open, "");
+static const TimeInfo kTimeInfo("Europe/Belgrade",
+                                "CET-1CEST,M3.5.0,M10.5.0/3");
+
+// large enough for every section payload
+static constexpr size_t kMaxPayloadLength = 512;
+
+// The encoders and decoders below follow config_store.cpp, the encoders copy
+// the payload out as they run outside of the measured loops
+
+static std::vector<uint8_t> encodeLedInfo(const LedInfo& ledInfo) {
+    uint8_t payload[kMaxPayloadLength];
+    RecordWriter writer(payload, sizeof(payload));
+    writer.putU8(ledInfo.getRed());
+    writer.putU8(ledInfo.getGreen());
+    writer.putU8(ledInfo.getBlue());
+    writer.putU8(static_cast<uint8_t>(ledInfo.getState()));
+    return std::vector<uint8_t>(payload, payload + writer.getSize());
+}
+
+static std::vector<uint8_t> encodeSleepInfo(const SleepInfo& sleepInfo) {
+    uint8_t payload[kMaxPayloadLength];
+    RecordWriter writer(payload, sizeof(payload));
+    writer.putU16(sleepInfo.getSleepBefore());
+    writer.putU16(sleepInfo.getSleepAfter());
+    return std::vector<uint8_t>(payload, payload + writer.getSize());
+}
+
+static std::vector<uint8_t> encodeWifiInfo(const WifiInfo& wifiInfo) {
+    uint8_t payload[kMaxPayloadLength];
+    RecordWriter writer(payload, sizeof(payload));
+    writer.putString(wifiInfo.getHostname());
+    writer.putString(wifiInfo.getSSID());
+    writer.putU8(static_cast<uint8_t>(wifiInfo.getAuthType()));
+    writer.putString(wifiInfo.getPassword());
+    return std::vector<uint8_t>(payload, payload + writer.getSize());
+}
+
+static std::vector<uint8_t> encodeTimeInfo(const TimeInfo& timeInfo) {
+    uint8_t payload[kMaxPayloadLength];
+    RecordWriter writer(payload, sizeof(payload));
+    writer.putString(timeInfo.getTzZone());
+    writer.putString(timeInfo.getTzOffset());
+    writer.putU8(static_cast<uint8_t>(timeInfo.getTimeFormat()));
+    writer.putU8(timeInfo.getNtpServerCount());
+    for (uint8_t i = 0; i < timeInfo.getNtpServerCount(); ++i) {
+        writer.putString(timeInfo.getNtpServer(i));
+    }
+    return std::vector<uint8_t>(payload, payload + writer.getSize());
+}
+
+/**
+ * @brief Get the record file content of a payload
+ */
+static std::vector<uint8_t> makeRecord(const std::vector<uint8_t>& payload) {
+    RecordHeader header = {};
+    header.magic = kRecordMagic;
+    header.version = kVersion;
+    header.length = payload.size();
+    header.crc = esp_rom_crc32_le(0, payload.data(), payload.size());
+    std::vector<uint8_t> record(sizeof(header) + payload.size());
+    memcpy(record.data(), &header, sizeof(header));
+    memcpy(record.data() + sizeof(header), payload.data(), payload.size());
+    return record;
+}
+
+/**
+ * @brief Check a record file content
+ *
+ * @return payload, nullptr if the record is not intact
+ */
+static const uint8_t* decodeRecord(const std::vector<uint8_t>& record,
+                                   size_t& length) {
+    RecordHeader header;
+    if (record.size() < sizeof(header)) {
+        return nullptr;
+    }
+    memcpy(&header, record.data(), sizeof(header));
+    if (header.magic != kRecordMagic || header.version != kVersion ||
+        header.length != record.size() - sizeof(header)) {
+        return nullptr;
+    }
+    const uint8_t* payload = record.data() + sizeof(header);
+    if (esp_rom_crc32_le(0, payload, header.length) != header.crc) {
+        return nullptr;
+    }
+    length = header.length;
+    return payload;
+}
+
+static std::optional<LedInfo> decodeLedInfo(const uint8_t* payload,
+                                            size_t length) {
+    RecordReader reader(payload, length);
+    LedInfo ledInfo;
+    ledInfo.setRed(reader.getU8());
+    ledInfo.setGreen(reader.getU8());
+    ledInfo.setBlue(reader.getU8());
+    uint8_t state = reader.getU8();
+    if (!reader.isValid() || state > static_cast<uint8_t>(LedState::Pulse)) {
+        return std::nullopt;
+    }
+    ledInfo.setState(static_cast<LedState>(state));
+    return ledInfo;
+}
+
+static std::optional<SleepInfo> decodeSleepInfo(const uint8_t* payload,
+                                                size_t length) {
+    RecordReader reader(payload, length);
+    SleepInfo sleepInfo;
+    sleepInfo.setSleepBefore(reader.getU16());
+    sleepInfo.setSleepAfter(reader.getU16());
+    if (!reader.isValid()) {
+        return std::nullopt;
+    }
+    return sleepInfo;
+}
+
+static std::optional<WifiInfo> decodeWifiInfo(const uint8_t* payload,
+                                              size_t length) {
+    RecordReader reader(payload, length);
+    char hostname[WifiInfo::kHostnameSize];
+    char ssid[WifiInfo::kSsidSize];
+    char password[WifiInfo::kPasswordSize];
+    reader.getString(hostname, sizeof(hostname));
+    reader.getString(ssid, sizeof(ssid));
+    uint8_t authType = reader.getU8();
+    reader.getString(password, sizeof(password));
+    if (!reader.isValid() ||
+        authType > static_cast<uint8_t>(WifiAuthType::WPA3)) {
+        return std::nullopt;
+    }
+    return WifiInfo(hostname, ssid, static_cast<WifiAuthType>(authType),
+                    password);
+}
+
+static std::optional<TimeInfo> decodeTimeInfo(const uint8_t* payload,
+                                              size_t length) {
+    RecordReader reader(payload, length);
+    char tzZone[TimeInfo::kTzZoneSize];
+    char tzOffset[TimeInfo::kTzOffsetSize];
+    reader.getString(tzZone, sizeof(tzZone));
+    reader.getString(tzOffset, sizeof(tzOffset));
+    TimeInfo timeInfo(tzZone, tzOffset);
+    uint8_t timeFormat = reader.getU8();
+    uint8_t ntpServerCount = reader.getU8();
+    if (ntpServerCount > 0) {
+        timeInfo.clearNtpServers();
+    }
+    for (uint8_t i = 0; i < ntpServerCount; ++i) {
+        char server[TimeInfo::kNtpServerSize];
+        reader.getString(server, sizeof(server));
+        timeInfo.addNtpServer(server);
+    }
+    if (!reader.isValid() ||
+        timeFormat > static_cast<uint8_t>(TimeFormat::Hour12) ||
+        ntpServerCount > TimeInfo::kMaxNtpServers) {
+        return std::nullopt;
+    }
+    timeInfo.setTimeFormat(static_cast<TimeFormat>(timeFormat));
+    return timeInfo;
+}
+
+/**
+ * @brief Load a record the way ConfigStore does after reading the file
+ *
+ * Reports the record size as the "bytes" counter.
+ */
+template <typename T>
+static void runRecord(benchmark::State& state,
+                      const std::vector<uint8_t>& payload,
+                      std::optional<T> (*decode)(const uint8_t*, size_t)) {
+    const std::vector<uint8_t> record = makeRecord(payload);
+    for (auto _ : state) {
+        size_t length = 0;
+        const uint8_t* data = decodeRecord(record, length);
+        std::optional<T> info;
+        if (data != nullptr) {
+            info = decode(data, length);
+        }
+        if (!info.has_value()) {
+            state.SkipWithError("record not decoded");
+            break;
+        }
+        benchmark::DoNotOptimize(info);
+    }
+    state.counters["bytes"] = record.size();
+}
+
+static void BM_RecordLedInfo(benchmark::State& state) {
+    runRecord(state, encodeLedInfo(kLedInfo), decodeLedInfo);
+}
+BENCHMARK(BM_RecordLedInfo);
+
+static void BM_RecordSleepInfo(benchmark::State& state) {
+    runRecord(state, encodeSleepInfo(kSleepInfo), decodeSleepInfo);
+}
+BENCHMARK(BM_RecordSleepInfo);
+
+static void BM_RecordWifiInfo(benchmark::State& state) {
+    runRecord(state, encodeWifiInfo(kWifiInfo), decodeWifiInfo);
+}
+BENCHMARK(BM_RecordWifiInfo);
+
+static void BM_RecordTimeInfo(benchmark::State& state) {
+    runRecord(state, encodeTimeInfo(kTimeInfo), decodeTimeInfo);
+}
+BENCHMARK(BM_RecordTimeInfo);
+
+#if defined(HAVE_CJSON)
+// The parsers below follow the readXJson() functions of config_store.cpp
+
+static std::optional<LedInfo> parseLedInfo(const char* content) {
+    cJSON* json = cJSON_Parse(content);
+    if (json == nullptr || !cJSON_GetObjectItemCaseSensitive(json, "R") ||
+        !cJSON_GetObjectItemCaseSensitive(json, "G") ||
+        !cJSON_GetObjectItemCaseSensitive(json, "B")) {
+        cJSON_Delete(json);
+        return std::nullopt;
+    }
+    LedInfo ledInfo;
+    ledInfo.setColor(cJSON_GetObjectItemCaseSensitive(json, "R")->valueint,
+                     cJSON_GetObjectItemCaseSensitive(json, "G")->valueint,
+                     cJSON_GetObjectItemCaseSensitive(json, "B")->valueint);
+    std::string state =
+        cJSON_GetObjectItemCaseSensitive(json, "state")->valuestring;
+    if (state == "on") {
+        ledInfo.setState(LedState::On);
+    } else if (state == "off") {
+        ledInfo.setState(LedState::Off);
+    } else if (state == "fade") {
+        ledInfo.setState(LedState::Fade);
+    } else if (state == "pulse") {
+        ledInfo.setState(LedState::Pulse);
+    }
+    cJSON_Delete(json);
+    return ledInfo;
+}
+
+static std::optional<SleepInfo> parseSleepInfo(const char* content) {
+    cJSON* json = cJSON_Parse(content);
+    if (json == nullptr ||
+        !cJSON_GetObjectItemCaseSensitive(json, "sleep_before") ||
+        !cJSON_GetObjectItemCaseSensitive(json, "sleep_after")) {
+        cJSON_Delete(json);
+        return std::nullopt;
+    }
+    SleepInfo sleepInfo;
+    sleepInfo.setSleepBefore(
+        cJSON_GetObjectItemCaseSensitive(json, "sleep_before")->valueint);
+    sleepInfo.setSleepAfter(
+        cJSON_GetObjectItemCaseSensitive(json, "sleep_after")->valueint);
+    cJSON_Delete(json);
+    return sleepInfo;
+}
+
+static std::optional<WifiInfo> parseWifiInfo(const char* content) {
+    cJSON* json = cJSON_Parse(content);
+    if (json == nullptr ||
+        !cJSON_GetObjectItemCaseSensitive(json, "hostname") ||
+        !cJSON_GetObjectItemCaseSensitive(json, "SSID") ||
+        !cJSON_GetObjectItemCaseSensitive(json, "auth_type") ||
+        !cJSON_GetObjectItemCaseSensitive(json, "password")) {
+        cJSON_Delete(json);
+        return std::nullopt;
+    }
+    WifiInfo wifiInfo;
+    wifiInfo.setHostname(
+        cJSON_GetObjectItemCaseSensitive(json, "hostname")->valuestring);
+    wifiInfo.setSSID(
+        cJSON_GetObjectItemCaseSensitive(json, "SSID")->valuestring);
+    std::string authType =
+        cJSON_GetObjectItemCaseSensitive(json, "auth_type")->valuestring;
+    if (authType == "open") {
+        wifiInfo.setAuthType(WifiAuthType::Open);
+    } else if (authType == "wpa2") {
+        wifiInfo.setAuthType(WifiAuthType::WPA2);
+    } else if (authType == "wpa3") {
+        wifiInfo.setAuthType(WifiAuthType::WPA3);
+    } else {
+        cJSON_Delete(json);
+        return std::nullopt;
+    }
+    wifiInfo.setPassword(
+        cJSON_GetObjectItemCaseSensitive(json, "password")->valuestring);
+    cJSON_Delete(json);
+    return wifiInfo;
+}
+
+static std::optional<TimeInfo> parseTimeInfo(const char* content) {
+    cJSON* json = cJSON_Parse(content);
+    if (json == nullptr ||
+        !cJSON_GetObjectItemCaseSensitive(json, "tz_zone") ||
+        !cJSON_GetObjectItemCaseSensitive(json, "tz_offset") ||
+        !cJSON_GetObjectItemCaseSensitive(json, "time_format")) {
+        cJSON_Delete(json);
+        return std::nullopt;
+    }
+    TimeInfo timeInfo;
+    timeInfo.setTzZone(
+        cJSON_GetObjectItemCaseSensitive(json, "tz_zone")->valuestring);
+    timeInfo.setTzOffset(
+        cJSON_GetObjectItemCaseSensitive(json, "tz_offset")->valuestring);
+    std::string timeFormat =
+        cJSON_GetObjectItemCaseSensitive(json, "time_format")->valuestring;
+    if (timeFormat == "24h") {
+        timeInfo.setTimeFormat(TimeFormat::Hour24);
+    } else if (timeFormat == "12h") {
+        timeInfo.setTimeFormat(TimeFormat::Hour12);
+    } else {
+        cJSON_Delete(json);
+        return std::nullopt;
+    }
+    cJSON* ntpServersJson =
+        cJSON_GetObjectItemCaseSensitive(json, "ntp_servers");
+    if (cJSON_IsArray(ntpServersJson)) {
+        TimeInfo serversInfo = timeInfo;
+        serversInfo.clearNtpServers();
+        cJSON* server = nullptr;
+        cJSON_ArrayForEach(server, ntpServersJson) {
+            if (cJSON_IsString(server)) {
+                serversInfo.addNtpServer(server->valuestring);
+            }
+        }
+        if (serversInfo.getNtpServerCount() > 0) {
+            timeInfo = serversInfo;
+        }
+    }
+    cJSON_Delete(json);
+    return timeInfo;
+}
+
+#elif defined(HAVE_JSONCPP)
+// Without the ESP-IDF sources the baseline falls back to jsoncpp, another
+// parser building a heap allocated tree. The parsers below check the same
+// fields as the readXJson() functions of config_store.cpp, the numbers are
+// an estimate of the cJSON path only.
+
+static Json::CharReader* getJsonReader() {
+    static std::unique_ptr<Json::CharReader> reader(
+        Json::CharReaderBuilder().newCharReader());
+    return reader.get();
+}
+
+/**
+ * @brief Parse a JSON object
+ *
+ * @return True if the content is a JSON object
+ */
+static bool parseJson(const char* content, Json::Value& json) {
+    return getJsonReader()->parse(content, content + strlen(content), &json,
+                                  nullptr) &&
+           json.isObject();
+}
+
+static std::optional<LedInfo> parseLedInfo(const char* content) {
+    Json::Value json;
+    if (!parseJson(content, json) || !json.isMember("R") ||
+        !json.isMember("G") || !json.isMember("B")) {
+        return std::nullopt;
+    }
+    LedInfo ledInfo;
+    ledInfo.setColor(json["R"].asInt(), json["G"].asInt(), json["B"].asInt());
+    std::string state = json["state"].asString();
+    if (state == "on") {
+        ledInfo.setState(LedState::On);
+    } else if (state == "off") {
+        ledInfo.setState(LedState::Off);
+    } else if (state == "fade") {
+        ledInfo.setState(LedState::Fade);
+    } else if (state == "pulse") {
+        ledInfo.setState(LedState::Pulse);
+    }
+    return ledInfo;
+}
+
+static std::optional<SleepInfo> parseSleepInfo(const char* content) {
+    Json::Value json;
+    if (!parseJson(content, json) || !json.isMember("sleep_before") ||
+        !json.isMember("sleep_after")) {
+        return std::nullopt;
+    }
+    SleepInfo sleepInfo;
+    sleepInfo.setSleepBefore(json["sleep_before"].asInt());
+    sleepInfo.setSleepAfter(json["sleep_after"].asInt());
+    return sleepInfo;
+}
+
+static std::optional<WifiInfo> parseWifiInfo(const char* content) {
+    Json::Value json;
+    if (!parseJson(content, json) || !json.isMember("hostname") ||
+        !json.isMember("SSID") || !json.isMember("auth_type") ||
+        !json.isMember("password")) {
+        return std::nullopt;
+    }
+    WifiInfo wifiInfo;
+    if (!wifiInfo.setHostname(json["hostname"].asCString()) ||
+        !wifiInfo.setSSID(json["SSID"].asCString()) ||
+        !wifiInfo.setPassword(json["password"].asCString())) {
+        return std::nullopt;
+    }
+    std::string authType = json["auth_type"].asString();
+    if (authType == "open") {
+        wifiInfo.setAuthType(WifiAuthType::Open);
+    } else if (authType == "wpa2") {
+        wifiInfo.setAuthType(WifiAuthType::WPA2);
+    } else if (authType == "wpa3") {
+        wifiInfo.setAuthType(WifiAuthType::WPA3);
+    } else {
+        return std::nullopt;
+    }
+    return wifiInfo;
+}
+
+static std::optional<TimeInfo> parseTimeInfo(const char* content) {
+    Json::Value json;
+    if (!parseJson(content, json) || !json.isMember("tz_zone") ||
+        !json.isMember("tz_offset") || !json.isMember("time_format")) {
+        return std::nullopt;
+    }
+    TimeInfo timeInfo;
+    if (!timeInfo.setTzZone(json["tz_zone"].asCString()) ||
+        !timeInfo.setTzOffset(json["tz_offset"].asCString())) {
+        return std::nullopt;
+    }
+    std::string timeFormat = json["time_format"].asString();
+    if (timeFormat == "24h") {
+        timeInfo.setTimeFormat(TimeFormat::Hour24);
+    } else if (timeFormat == "12h") {
+        timeInfo.setTimeFormat(TimeFormat::Hour12);
+    } else {
+        return std::nullopt;
+    }
+    const Json::Value& ntpServersJson = json["ntp_servers"];
+    if (ntpServersJson.isArray()) {
+        TimeInfo serversInfo = timeInfo;
+        serversInfo.clearNtpServers();
+        for (const Json::Value& server : ntpServersJson) {
+            if (server.isString()) {
+                serversInfo.addNtpServer(server.asCString());
+            }
+        }
+        if (serversInfo.getNtpServerCount() > 0) {
+            timeInfo = serversInfo;
+        }
+    }
+    return timeInfo;
+}
+#endif
+
+#if defined(HAVE_CJSON) || defined(HAVE_JSONCPP)
+/**
+ * @brief Read a default config file of the LittleFS image
+ */
+static std::string readConfigFile(const char* name) {
+    std::ifstream file(std::string(CONFIG_DIR) + "/" + name);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+/**
+ * @brief Load a JSON config file the way ConfigStore did after reading it
+ *
+ * The parsed section has to encode to the same record as the defaults used
+ * by the record benchmarks. Reports the file size as the "bytes" counter.
+ */
+template <typename T>
+static void runJson(benchmark::State& state, const char* name,
+                    std::optional<T> (*parse)(const char*),
+                    std::vector<uint8_t> (*encode)(const T&),
+                    const T& expected) {
+    const std::string content = readConfigFile(name);
+    std::optional<T> parsed = parse(content.c_str());
+    if (!parsed.has_value() || encode(*parsed) != encode(expected)) {
+        state.SkipWithError("the JSON file does not hold the defaults");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parse(content.c_str()));
+    }
+    state.counters["bytes"] = content.size();
+}
+
+static void BM_JsonLedInfo(benchmark::State& state) {
+    runJson(state, "led_info.json", parseLedInfo, encodeLedInfo, kLedInfo);
+}
+BENCHMARK(BM_JsonLedInfo);
+
+static void BM_JsonSleepInfo(benchmark::State& state) {
+    runJson(state, "sleep_info.json", parseSleepInfo, encodeSleepInfo,
+            kSleepInfo);
+}
+BENCHMARK(BM_JsonSleepInfo);
+
+static void BM_JsonWifiInfo(benchmark::State& state) {
+    runJson(state, "wifi_info.json", parseWifiInfo, encodeWifiInfo,
+            kWifiInfo);
+}
+BENCHMARK(BM_JsonWifiInfo);
+
+static void BM_JsonTimeInfo(benchmark::State& state) {
+    runJson(state, "time_info.json", parseTimeInfo, encodeTimeInfo,
+            kTimeInfo);
+}
+BENCHMARK(BM_JsonTimeInfo);
+#endif
+
+BENCHMARK_MAIN();
@@ -0,0 +1,173 @@
+/******************************************************************************
+ * File:    led_controller_test.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Stress tests of the SeqLock and the LED states it publishes
+ ******************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <inttypes.h>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "led_controller.h"
+
+static constexpr uint32_t kWriterIterations = 200000;
+// WS2812 high time of a one bit in RMT ticks, see led_controller.cpp
+static constexpr uint16_t kT1High = 9;
+
+static std::atomic<uint32_t> gFrameCount(0);
+static std::atomic<uint32_t> gInvalidFrameCount(0);
+static uint8_t gLastFrame[3];
+
+/**
+ * @brief Decode a byte of WS2812 symbols, MSB first
+ */
+static uint8_t decodeByte(const rmt_symbol_word_t* symbols) {
+    uint8_t value = 0;
+    for (int bit = 0; bit < 8; ++bit) {
+        value = (value << 1) | (symbols[bit].duration0 == kT1High);
+    }
+    return value;
+}
+
+/**
+ * @brief Check a frame sent by update()
+ *
+ * Writers set all color channels to the same value and turn the LED on for
+ * odd values only, so a frame rendered from a torn state shows up as
+ * differing channels or an even color.
+ */
+static void checkFrame(const rmt_symbol_word_t* symbols, size_t count) {
+    ASSERT_EQ(count, 25u);
+    // WS2812 uses GRB order
+    uint8_t green = decodeByte(&symbols[0]);
+    uint8_t red = decodeByte(&symbols[8]);
+    uint8_t blue = decodeByte(&symbols[16]);
+    if (red != green || red != blue || (red != 0 && red % 2 == 0)) {
+        gInvalidFrameCount++;
+    }
+    gLastFrame[0] = red;
+    gLastFrame[1] = green;
+    gLastFrame[2] = blue;
+    gFrameCount++;
+}
+
+/**
+ * @brief Let the renderer run between the writes on a single core host
+ */
+static void yieldSometimes(uint32_t iteration) {
+    if (iteration % 7 == 0) {
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * @brief Get the LED info the writers set for a value
+ */
+static LedInfo makeLedInfo(uint8_t value) {
+    return LedInfo(value, value, value,
+                   value % 2 ? LedState::On : LedState::Off);
+}
+
+TEST(SeqLockTest, ReaderNeverSeesTornValue) {
+    struct Snapshot {
+        uint32_t words[256];
+    };
+    SeqLock<Snapshot> lock;
+    std::atomic<bool> isDone(false);
+    std::atomic<uint32_t> tornCount(0);
+    std::atomic<uint32_t> reorderedCount(0);
+
+    auto reader = [&]() {
+        uint32_t last = 0;
+        while (!isDone.load()) {
+            Snapshot snapshot = lock.load();
+            for (uint32_t word : snapshot.words) {
+                if (word != snapshot.words[0]) {
+                    tornCount++;
+                    break;
+                }
+            }
+            // a single writer publishes increasing values
+            if (snapshot.words[0] < last) {
+                reorderedCount++;
+            }
+            last = snapshot.words[0];
+        }
+    };
+    std::thread firstReader(reader);
+    std::thread secondReader(reader);
+    for (uint32_t i = 1; i <= kWriterIterations; ++i) {
+        Snapshot snapshot;
+        std::fill(std::begin(snapshot.words), std::end(snapshot.words), i);
+        lock.store(snapshot);
+    }
+    isDone = true;
+    firstReader.join();
+    secondReader.join();
+
+    EXPECT_EQ(tornCount.load(), 0u);
+    EXPECT_EQ(reorderedCount.load(), 0u);
+    EXPECT_EQ(lock.generation(), kWriterIterations);
+    EXPECT_EQ(lock.load().words[0], kWriterIterations);
+}
+
+TEST(LedControllerTest, UpdateNeverRendersMixedStates) {
+    LedController ledController(GPIO_NUM_15);
+    ledController.initialize(makeLedInfo(0));
+    rmt_transmit_hook = checkFrame;
+    std::atomic<bool> isDone(false);
+
+    // base colors are 0-127 and temporal colors 128-255, update() renders
+    // whichever is active while the setters run
+    std::thread renderer([&]() {
+        while (!isDone.load()) {
+            ledController.update();
+            std::this_thread::yield();
+        }
+    });
+    std::vector<std::thread> writers;
+    writers.emplace_back([&]() {
+        for (uint32_t i = 0; i < kWriterIterations; ++i) {
+            ledController.setLedInfo(makeLedInfo(i % 128));
+            yieldSometimes(i);
+        }
+    });
+    writers.emplace_back([&]() {
+        for (uint32_t i = 0; i < kWriterIterations; ++i) {
+            ledController.setTemporalState(makeLedInfo(128 + i % 128));
+            yieldSometimes(i);
+        }
+    });
+    writers.emplace_back([&]() {
+        for (uint32_t i = 0; i < kWriterIterations; ++i) {
+            ledController.clearTemporalState();
+            yieldSometimes(i);
+        }
+    });
+    for (std::thread& writer : writers) {
+        writer.join();
+    }
+    isDone = true;
+    renderer.join();
+
+    // the last base state is rendered once the temporal state is cleared
+    ledController.clearTemporalState();
+    ledController.update();
+    rmt_transmit_hook = nullptr;
+
+    EXPECT_GT(gFrameCount.load(), 1u);
+    EXPECT_EQ(gInvalidFrameCount.load(), 0u);
+    uint8_t lastValue = (kWriterIterations - 1) % 128;
+    EXPECT_EQ(gLastFrame[0], lastValue);
+    EXPECT_EQ(gLastFrame[1], lastValue);
+    EXPECT_EQ(gLastFrame[2], lastValue);
+    LedFrameStats stats = ledController.getFrameStats();
+    EXPECT_GE(stats.rendered, stats.sent);
+    EXPECT_EQ(stats.sent, gFrameCount.load());
+}
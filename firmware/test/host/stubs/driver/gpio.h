@@ -0,0 +1,16 @@
+/******************************************************************************
+ * File:    gpio.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Host stub of the ESP-IDF GPIO driver types
+ ******************************************************************************/
+
+#ifndef gpio_h
+#define gpio_h
+
+typedef enum {
+    GPIO_NUM_NC = -1,
+    GPIO_NUM_15 = 15,
+} gpio_num_t;
+
+#endif   // gpio_h
@@ -0,0 +1,116 @@
+/******************************************************************************
+ * File:    rmt_tx.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Host stub of the ESP-IDF RMT transmit driver, nothing is sent
+ ******************************************************************************/
+
+#ifndef rmt_tx_h
+#define rmt_tx_h
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+
+#define RMT_CLK_SRC_DEFAULT 0
+
+typedef struct rmt_channel_t* rmt_channel_handle_t;
+typedef struct rmt_encoder_t* rmt_encoder_handle_t;
+
+typedef union {
+    struct {
+        uint16_t duration0 : 15;
+        uint16_t level0 : 1;
+        uint16_t duration1 : 15;
+        uint16_t level1 : 1;
+    };
+    uint32_t val;
+} rmt_symbol_word_t;
+
+typedef struct {
+    gpio_num_t gpio_num;
+    int clk_src;
+    uint32_t resolution_hz;
+    size_t mem_block_symbols;
+    size_t trans_queue_depth;
+    struct {
+        uint32_t with_dma : 1;
+    } flags;
+} rmt_tx_channel_config_t;
+
+typedef struct {
+    int loop_count;
+} rmt_transmit_config_t;
+
+typedef struct {
+    size_t num_symbols;
+} rmt_tx_done_event_data_t;
+
+typedef bool (*rmt_tx_done_callback_t)(rmt_channel_handle_t channel,
+                                       const rmt_tx_done_event_data_t* edata,
+                                       void* param);
+
+typedef struct {
+    rmt_tx_done_callback_t on_trans_done;
+} rmt_tx_event_callbacks_t;
+
+typedef struct {
+} rmt_copy_encoder_config_t;
+
+inline esp_err_t rmt_new_tx_channel(const rmt_tx_channel_config_t* config,
+                                    rmt_channel_handle_t* channel) {
+    return ESP_OK;
+}
+
+inline esp_err_t rmt_new_copy_encoder(const rmt_copy_encoder_config_t* config,
+                                      rmt_encoder_handle_t* encoder) {
+    return ESP_OK;
+}
+
+// the transmit done callback, called at the end of rmt_transmit()
+inline rmt_tx_done_callback_t rmt_done_callback = nullptr;
+inline void* rmt_done_param = nullptr;
+
+inline esp_err_t
+rmt_tx_register_event_callbacks(rmt_channel_handle_t channel,
+                                const rmt_tx_event_callbacks_t* callbacks,
+                                void* param) {
+    rmt_done_callback = callbacks->on_trans_done;
+    rmt_done_param = param;
+    return ESP_OK;
+}
+
+inline esp_err_t rmt_enable(rmt_channel_handle_t channel) { return ESP_OK; }
+
+inline esp_err_t rmt_disable(rmt_channel_handle_t channel) { return ESP_OK; }
+
+/**
+ * @brief Host only, called with the symbols of every transmission
+ */
+typedef void (*rmt_transmit_hook_t)(const rmt_symbol_word_t* symbols,
+                                    size_t count);
+inline rmt_transmit_hook_t rmt_transmit_hook = nullptr;
+
+inline esp_err_t rmt_transmit(rmt_channel_handle_t channel,
+                              rmt_encoder_handle_t encoder,
+                              const void* payload, size_t size,
+                              const rmt_transmit_config_t* config) {
+    if (rmt_transmit_hook != nullptr) {
+        rmt_transmit_hook(static_cast<const rmt_symbol_word_t*>(payload),
+                          size / sizeof(rmt_symbol_word_t));
+    }
+    if (rmt_done_callback != nullptr) {
+        rmt_tx_done_event_data_t data = {size / sizeof(rmt_symbol_word_t)};
+        rmt_done_callback(channel, &data, rmt_done_param);
+    }
+    return ESP_OK;
+}
+
+inline esp_err_t rmt_tx_wait_all_done(rmt_channel_handle_t channel,
+                                      int timeoutMs) {
+    return ESP_OK;
+}
+
+#endif   // rmt_tx_h
@@ -0,0 +1,17 @@
+/******************************************************************************
+ * File:    esp_err.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Host stub of the ESP-IDF error codes
+ ******************************************************************************/
+
+#ifndef esp_err_h
+#define esp_err_h
+
+typedef int esp_err_t;
+
+#define ESP_OK 0
+#define ESP_FAIL -1
+#define ESP_ERROR_CHECK(x) ((void)(x))
+
+#endif   // esp_err_h
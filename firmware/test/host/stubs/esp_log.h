@@ -0,0 +1,17 @@
+/******************************************************************************
+ * File:    esp_log.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Host stub of the ESP-IDF logging macros, logs are dropped
+ ******************************************************************************/
+
+#ifndef esp_log_h
+#define esp_log_h
+
+#define ESP_LOGE(tag, ...) ((void)(tag))
+#define ESP_LOGW(tag, ...) ((void)(tag))
+#define ESP_LOGI(tag, ...) ((void)(tag))
+#define ESP_LOGD(tag, ...) ((void)(tag))
+#define ESP_LOGV(tag, ...) ((void)(tag))
+
+#endif   // esp_log_h
@@ -0,0 +1,14 @@
+/******************************************************************************
+ * File:    esp_rom_crc.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Implements the host stub of the ESP ROM CRC functions with zlib
+ ******************************************************************************/
+
+#include "esp_rom_crc.h"
+
+#include <zlib.h>
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len) {
+    return crc32(crc, buf, len);
+}
@@ -0,0 +1,18 @@
+/******************************************************************************
+ * File:    esp_rom_crc.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Host stub of the ESP ROM CRC functions
+ ******************************************************************************/
+
+#ifndef esp_rom_crc_h
+#define esp_rom_crc_h
+
+#include <inttypes.h>
+
+/**
+ * @brief CRC-32 (IEEE 802.3) as computed by the ROM, zlib compatible
+ */
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len);
+
+#endif   // esp_rom_crc_h
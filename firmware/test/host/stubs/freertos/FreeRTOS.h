@@ -0,0 +1,21 @@
+/******************************************************************************
+ * File:    FreeRTOS.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Host stub of the FreeRTOS base definitions
+ ******************************************************************************/
+
+#ifndef freertos_h
+#define freertos_h
+
+#include <inttypes.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xffffffffu
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+#endif   // freertos_h
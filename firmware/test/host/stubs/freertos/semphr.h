@@ -0,0 +1,20 @@
+/******************************************************************************
+ * File:    semphr.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Host stub of the FreeRTOS mutex API, backed by std::timed_mutex
+ ******************************************************************************/
+
+#ifndef semphr_h
+#define semphr_h
+
+#include "freertos/FreeRTOS.h"
+
+typedef struct QueueDefinition* SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex();
+void vSemaphoreDelete(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+#endif   // semphr_h
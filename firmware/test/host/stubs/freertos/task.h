@@ -0,0 +1,15 @@
+/******************************************************************************
+ * File:    task.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Host stub of the FreeRTOS task API
+ ******************************************************************************/
+
+#ifndef task_h
+#define task_h
+
+#include "freertos/FreeRTOS.h"
+
+void vTaskDelay(TickType_t ticks);
+
+#endif   // task_h
@@ -0,0 +1,41 @@
+/******************************************************************************
+ * File:    freertos_stubs.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Implements the host stubs of the FreeRTOS API
+ ******************************************************************************/
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+// one tick is one millisecond, as pdMS_TO_TICKS() of the stub assumes
+struct QueueDefinition {
+    std::timed_mutex mutex;
+};
+
+SemaphoreHandle_t xSemaphoreCreateMutex() { return new QueueDefinition; }
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) { delete semaphore; }
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        semaphore->mutex.lock();
+        return pdTRUE;
+    }
+    return semaphore->mutex.try_lock_for(std::chrono::milliseconds(ticks))
+               ? pdTRUE
+               : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    semaphore->mutex.unlock();
+    return pdTRUE;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
@@ -0,0 +1,13 @@
+/******************************************************************************
+ * File:    soc_caps.h
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Host stub of the SoC capabilities
+ ******************************************************************************/
+
+#ifndef soc_caps_h
+#define soc_caps_h
+
+#define SOC_RMT_SUPPORT_DMA 0
+
+#endif   // soc_caps_h
@@ -0,0 +1,129 @@
+/******************************************************************************
+ * File:    time_zone_bench.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Benchmarks TimeZone against the glibc TZ machinery
+ ******************************************************************************/
+
+#include <cstdlib>
+#include <ctime>
+
+#include <benchmark/benchmark.h>
+
+#include "time_zone.h"
+
+static constexpr const char* kRule = "CET-1CEST,M3.5.0,M10.5.0/3";
+// 2025-01-01 00:00:00 UTC
+static constexpr time_t kStartTime = 1735689600;
+
+/**
+ * @brief Use the rule in the glibc TZ machinery
+ */
+static void setLibcRule() {
+    setenv("TZ", kRule, 1);
+    tzset();
+}
+
+// TimeKeeper converts once per second, which mostly hits the cached offset
+static void BM_TimeZoneToLocal(benchmark::State& state) {
+    TimeZone timeZone;
+    timeZone.setRule(kRule);
+    time_t utc = kStartTime;
+    struct tm local;
+    for (auto _ : state) {
+        timeZone.toLocal(utc++, &local);
+        benchmark::DoNotOptimize(local);
+    }
+}
+BENCHMARK(BM_TimeZoneToLocal);
+
+static void BM_LocaltimeLibc(benchmark::State& state) {
+    setLibcRule();
+    time_t utc = kStartTime;
+    struct tm local;
+    for (auto _ : state) {
+        localtime_r(&utc, &local);
+        utc++;
+        benchmark::DoNotOptimize(local);
+    }
+}
+BENCHMARK(BM_LocaltimeLibc);
+
+// a step of a bit more than a week crosses a transition every few months,
+// the cache misses then
+static void BM_TimeZoneToLocalWeekly(benchmark::State& state) {
+    TimeZone timeZone;
+    timeZone.setRule(kRule);
+    time_t utc = kStartTime;
+    struct tm local;
+    for (auto _ : state) {
+        timeZone.toLocal(utc, &local);
+        utc += 7 * 86400 + 3607;
+        benchmark::DoNotOptimize(local);
+    }
+}
+BENCHMARK(BM_TimeZoneToLocalWeekly);
+
+static void BM_LocaltimeLibcWeekly(benchmark::State& state) {
+    setLibcRule();
+    time_t utc = kStartTime;
+    struct tm local;
+    for (auto _ : state) {
+        localtime_r(&utc, &local);
+        utc += 7 * 86400 + 3607;
+        benchmark::DoNotOptimize(local);
+    }
+}
+BENCHMARK(BM_LocaltimeLibcWeekly);
+
+/**
+ * @brief Convert local times of a day in June with a time zone
+ *
+ * @param isCached the offset of the day is cached, as it is when TimeKeeper
+ * converts the current time once per second
+ */
+static void runToUtc(benchmark::State& state, bool isCached) {
+    TimeZone timeZone;
+    timeZone.setRule(kRule);
+    struct tm local = {};
+    local.tm_year = 2025 - 1900;
+    local.tm_mon = 5;
+    local.tm_mday = 15;
+    if (isCached) {
+        struct tm now;
+        timeZone.toLocal(timeZone.toUtc(local), &now);
+    }
+    for (auto _ : state) {
+        local.tm_min = (local.tm_min + 1) % 60;
+        benchmark::DoNotOptimize(timeZone.toUtc(local));
+    }
+}
+
+static void BM_TimeZoneToUtc(benchmark::State& state) {
+    runToUtc(state, true);
+}
+BENCHMARK(BM_TimeZoneToUtc);
+
+// every lookup computes the transitions of three years from the rule
+static void BM_TimeZoneToUtcUncached(benchmark::State& state) {
+    runToUtc(state, false);
+}
+BENCHMARK(BM_TimeZoneToUtcUncached);
+
+static void BM_MktimeLibc(benchmark::State& state) {
+    setLibcRule();
+    struct tm local = {};
+    local.tm_year = 2025 - 1900;
+    local.tm_mon = 5;
+    local.tm_mday = 15;
+    for (auto _ : state) {
+        // mktime() normalizes its argument
+        struct tm copy = local;
+        copy.tm_min = (local.tm_min = (local.tm_min + 1) % 60);
+        copy.tm_isdst = -1;
+        benchmark::DoNotOptimize(mktime(&copy));
+    }
+}
+BENCHMARK(BM_MktimeLibc);
+
+BENCHMARK_MAIN();
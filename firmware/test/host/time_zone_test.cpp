@@ -0,0 +1,185 @@
+/******************************************************************************
+ * File:    time_zone_test.cpp
+ * Author:  Daniel Knezevic
+ * Year:    2025
+ * Brief:   Compares TimeZone with glibc for every rule of zones.json
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "time_zone.h"
+
+// 2000-01-01 and 2034-01-01 00:00:00 UTC
+static constexpr time_t kStartTime = 946684800;
+static constexpr time_t kEndTime = 2019686400;
+// a day and a bit, so the time of day of the samples drifts, transitions
+// between two samples are searched for
+static constexpr time_t kStep = 86400 + 7;
+
+/**
+ * @brief Get the distinct rules of the zone list used by the firmware
+ *
+ * zones.json holds one "zone":"rule" pair per line.
+ */
+static std::set<std::string> loadRules() {
+    std::ifstream file(ZONES_JSON);
+    std::stringstream content;
+    content << file.rdbuf();
+    std::set<std::string> rules;
+    std::string line;
+    while (std::getline(content, line)) {
+        size_t separator = line.find("\":\"");
+        size_t end = line.rfind('"');
+        if (separator != std::string::npos && end > separator + 3) {
+            rules.insert(line.substr(separator + 3, end - separator - 3));
+        }
+    }
+    return rules;
+}
+
+/**
+ * @brief Use a rule in the glibc TZ machinery
+ */
+static void setLibcRule(const std::string& rule) {
+    setenv("TZ", rule.c_str(), 1);
+    tzset();
+}
+
+/**
+ * @brief Convert a local time to UTC the way TimeZone::toUtc() documents it
+ *
+ * mktime() with tm_isdst -1 does not pick the earlier instant of a local
+ * time occurring twice for every rule, e.g. not for the 2 hour fold of
+ * "<+00>0<+02>-2,M3.5.0/1,M10.5.0/3". Both interpretations are tried and
+ * the earliest one which maps back to the same local time is used. A local
+ * time in a DST gap has none, mktime() moves it forward by the gap then.
+ */
+static time_t libcToUtc(const struct tm& local) {
+    time_t result = 0;
+    bool isFound = false;
+    // a rule without DST has a single interpretation, asking glibc for a
+    // DST one makes it search for a long time
+    for (int isDst = 0; isDst <= (daylight ? 1 : 0); ++isDst) {
+        struct tm copy = local;
+        copy.tm_isdst = isDst;
+        time_t utc = mktime(&copy);
+        struct tm check;
+        localtime_r(&utc, &check);
+        if (check.tm_year == local.tm_year && check.tm_mon == local.tm_mon &&
+            check.tm_mday == local.tm_mday && check.tm_hour == local.tm_hour &&
+            check.tm_min == local.tm_min && check.tm_sec == local.tm_sec &&
+            (!isFound || utc < result)) {
+            result = utc;
+            isFound = true;
+        }
+    }
+    if (!isFound) {
+        struct tm copy = local;
+        copy.tm_isdst = -1;
+        result = mktime(&copy);
+    }
+    return result;
+}
+
+/**
+ * @brief Compare one instant with localtime_r() and mktime()
+ */
+static void compareAt(const TimeZone& timeZone, time_t utc) {
+    struct tm expected;
+    localtime_r(&utc, &expected);
+    struct tm actual;
+    timeZone.toLocal(utc, &actual);
+    ASSERT_EQ(actual.tm_year, expected.tm_year) << "utc " << utc;
+    ASSERT_EQ(actual.tm_yday, expected.tm_yday) << "utc " << utc;
+    ASSERT_EQ(actual.tm_mon, expected.tm_mon) << "utc " << utc;
+    ASSERT_EQ(actual.tm_mday, expected.tm_mday) << "utc " << utc;
+    ASSERT_EQ(actual.tm_wday, expected.tm_wday) << "utc " << utc;
+    ASSERT_EQ(actual.tm_hour, expected.tm_hour) << "utc " << utc;
+    ASSERT_EQ(actual.tm_min, expected.tm_min) << "utc " << utc;
+    ASSERT_EQ(actual.tm_sec, expected.tm_sec) << "utc " << utc;
+    ASSERT_EQ(actual.tm_isdst, expected.tm_isdst) << "utc " << utc;
+
+    ASSERT_EQ(timeZone.toUtc(expected), libcToUtc(expected)) << "utc " << utc;
+}
+
+/**
+ * @brief Get the UTC offset of glibc
+ */
+static long getLibcOffset(time_t utc) {
+    struct tm local;
+    localtime_r(&utc, &local);
+    return local.tm_gmtoff;
+}
+
+TEST(TimeZoneTest, MatchesLocaltimeAndMktime) {
+    const std::set<std::string> rules = loadRules();
+    ASSERT_FALSE(rules.empty()) << "can not read " << ZONES_JSON;
+    for (const std::string& rule : rules) {
+        SCOPED_TRACE(rule);
+        TimeZone timeZone;
+        ASSERT_TRUE(timeZone.setRule(rule));
+        setLibcRule(rule);
+        long lastOffset = getLibcOffset(kStartTime);
+        for (time_t utc = kStartTime; utc < kEndTime; utc += kStep) {
+            ASSERT_NO_FATAL_FAILURE(compareAt(timeZone, utc));
+            long offset = getLibcOffset(utc);
+            if (offset == lastOffset) {
+                continue;
+            }
+            // a transition passed since the last sample, find its first
+            // second and compare both sides of it
+            time_t before = utc - kStep;
+            time_t after = utc;
+            while (after - before > 1) {
+                time_t middle = before + (after - before) / 2;
+                (getLibcOffset(middle) == lastOffset ? before : after) =
+                    middle;
+            }
+            ASSERT_NO_FATAL_FAILURE(compareAt(timeZone, before));
+            ASSERT_NO_FATAL_FAILURE(compareAt(timeZone, after));
+            lastOffset = offset;
+        }
+    }
+}
+
+TEST(TimeZoneTest, GapsAndFoldsMatchMktime) {
+    // northern and southern hemisphere rules and a half hour DST
+    const char* rules[] = {"CET-1CEST,M3.5.0,M10.5.0/3",
+                           "EST5EDT,M3.2.0,M11.1.0",
+                           "AEST-10AEDT,M10.1.0,M4.1.0/3",
+                           "<+1030>-10:30<+11>-11,M10.1.0,M4.1.0"};
+    for (const char* rule : rules) {
+        SCOPED_TRACE(rule);
+        TimeZone timeZone;
+        ASSERT_TRUE(timeZone.setRule(rule));
+        setLibcRule(rule);
+        for (int year = 2000; year < 2034; ++year) {
+            // the months of the transitions of the rules
+            for (int month : {2, 3, 9, 10}) {
+                for (int day = 1; day <= 31; ++day) {
+                    // every quarter hour, including the ones in a DST gap
+                    // and the ones occurring twice
+                    for (int minute = 0; minute < 24 * 60; minute += 15) {
+                        struct tm local = {};
+                        local.tm_year = year - 1900;
+                        local.tm_mon = month;
+                        local.tm_mday = day;
+                        local.tm_hour = minute / 60;
+                        local.tm_min = minute % 60;
+                        ASSERT_EQ(timeZone.toUtc(local), libcToUtc(local))
+                            << year << "-" << month + 1 << "-" << day << " "
+                            << minute / 60 << ":" << minute % 60;
+                    }
+                }
+            }
+        }
+    }
+}
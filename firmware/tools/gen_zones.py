@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+###############################################################################
+# Project:   SingleDigitNixieClock
+# File:      gen_zones.py
+# Author:    Daniel Knezevic
+# Year:      2025
+# Brief:     Compiles zones.json into the binary time zone table.
+###############################################################################
+"""Compile zones.json into the binary table read by TzDatabase.
+
+Layout (little endian):
+    header        magic "TZDB", version, block size, zone count, block
+                  count, rule count, entries offset, rules offset
+    block offsets uint16 per block, relative to the entries
+    rule offsets  uint16 per rule, relative to the rules
+    entries       sorted by name: shared prefix length (uint8), suffix
+                  length (uint8), suffix, rule index (uint8). The first
+                  entry of every block stores the full name.
+    rules         NUL terminated POSIX TZ strings, each stored once
+"""
+
+import json
+import struct
+import sys
+
+MAGIC = b"TZDB"
+VERSION = 1
+BLOCK_SIZE = 16
+MAX_NAME_LENGTH = 63
+HEADER = struct.Struct("<4sBBHHHII")
+
+
+def shared_prefix(a, b):
+    length = 0
+    while length < min(len(a), len(b)) and a[length] == b[length]:
+        length += 1
+    return length
+
+
+def compile_zones(zones):
+    names = sorted(zones)
+    rules = sorted(set(zones.values()))
+    rule_index = {rule: index for index, rule in enumerate(rules)}
+    if len(names) > 0xFFFF or len(rules) > 0xFF:
+        raise ValueError("too many zones or rules")
+
+    entries = bytearray()
+    block_offsets = []
+    previous = b""
+    for index, name in enumerate(names):
+        encoded = name.encode("ascii")
+        if (len(encoded) > MAX_NAME_LENGTH or b'"' in encoded
+                or b"\\" in encoded):
+            raise ValueError("invalid zone name: " + name)
+        shared = 0
+        if index % BLOCK_SIZE == 0:
+            block_offsets.append(len(entries))
+        else:
+            shared = shared_prefix(previous, encoded)
+        suffix = encoded[shared:]
+        entries += bytes([shared, len(suffix)]) + suffix
+        entries.append(rule_index[zones[name]])
+        previous = encoded
+
+    strings = bytearray()
+    rule_offsets = []
+    for rule in rules:
+        encoded = rule.encode("ascii")
+        if b'"' in encoded or b"\\" in encoded:
+            raise ValueError("invalid rule: " + rule)
+        rule_offsets.append(len(strings))
+        strings += encoded + b"\0"
+
+    if len(entries) > 0xFFFF or len(strings) > 0xFFFF:
+        raise ValueError("table too large")
+    tables = struct.pack("<%dH" % len(block_offsets), *block_offsets)
+    tables += struct.pack("<%dH" % len(rule_offsets), *rule_offsets)
+    entries_offset = HEADER.size + len(tables)
+    rules_offset = entries_offset + len(entries)
+    header = HEADER.pack(MAGIC, VERSION, BLOCK_SIZE, len(names),
+                         len(block_offsets), len(rules), entries_offset,
+                         rules_offset)
+    return header + tables + bytes(entries) + bytes(strings)
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit("usage: gen_zones.py <zones.json> <zones.bin>")
+    with open(sys.argv[1], encoding="utf-8") as source:
+        zones = json.load(source)
+    table = compile_zones(zones)
+    with open(sys.argv[2], "wb") as output:
+        output.write(table)
+    print("%d zones compiled into %d bytes" % (len(zones), len(table)))
+
+
+if __name__ == "__main__":
+    main()